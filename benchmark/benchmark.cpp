@@ -64,6 +64,13 @@ template <ConvertibleToString T> auto constant_formatter(const T &value) {
   return [value](auto &&...) { return convert_to_string(value); };
 }
 
+auto per_item_formatter(const double value,
+                        const std::vector<std::string> &arguments)
+    -> std::string {
+  return fmt::format("{:.3f}",
+                     value / static_cast<double>(std::stoul(arguments[1])));
+}
+
 auto throughput_formatter_n(const size_t n)
     -> std::function<std::string(const double,
                                  const std::vector<std::string> &)> {
@@ -139,6 +146,174 @@ BENCHMARK("deletion throughput") {
   summarize(index_formatter, multiply_formatter(1'000));
 }
 
+/* Insertions into single segments filled up to a load, instead of a number of
+ * elements (see the tasks) */
+BENCHMARK("high load insertion throughput") {
+  const auto load_formatter = [](const std::vector<std::string> &arguments) {
+    return arguments[1] + "%";
+  };
+
+  reset_benchmark({"DFF", "DFF_FG", "DFF_2C", "DFF_FG_2C"});
+  spdlog::info("Benchmarking {}...", name);
+  for (const size_t load : {85, 90, 95}) {
+    spdlog::info("Testing {} up to {}% load", name, load);
+    benchmark_all(INITIAL_CAPACITY_LOG2, load);
+  }
+  spdlog::info("Benchmarking {} done.\n", name);
+
+  spdlog::info("Insertion throughput by load (Mops):");
+  summarize(load_formatter, multiply_formatter(1 / 1'000'000.0));
+  std::cout << std::endl;
+
+  reset_benchmark({"KICKS_0", "KICKS_1", "KICKS_2", "KICKS_3", "KICKS_4",
+                   "KICKS_5", "FAILED"});
+  spdlog::info("Benchmarking {} kick counts...", name);
+  for (const size_t load : {85, 90, 95}) {
+    spdlog::info("Testing {} kick counts up to {}% load", name, load);
+    benchmark_all(INITIAL_CAPACITY_LOG2, load);
+  }
+  spdlog::info("Benchmarking {} kick counts done.\n", name);
+
+  spdlog::info("Insertions by number of tags moved (%):");
+  summarize(load_formatter, multiply_formatter(100));
+  std::cout << std::endl;
+
+  reset_benchmark({"KICKS_0_2C", "KICKS_1_2C", "KICKS_2_2C", "KICKS_3_2C",
+                   "KICKS_4_2C", "KICKS_5_2C", "FAILED_2C"});
+  spdlog::info("Benchmarking {} two-choice kick counts...", name);
+  for (const size_t load : {85, 90, 95}) {
+    spdlog::info("Testing {} two-choice kick counts up to {}% load", name,
+                 load);
+    benchmark_all(INITIAL_CAPACITY_LOG2, load);
+  }
+  spdlog::info("Benchmarking {} two-choice kick counts done.\n", name);
+
+  spdlog::info("Two-choice insertions by number of tags moved (%):");
+  summarize(load_formatter, multiply_formatter(100));
+}
+
+/* Insertions into filters expanding segments at different loads (80% to 95%,
+ * and adaptively, see the tasks) */
+BENCHMARK("load threshold") {
+  reset_benchmark({"DFF_80", "DFF_85", "DFF_90", "DFF_95", "DFF_ADAPTIVE"});
+  spdlog::info("Benchmarking {}...", name);
+  for (const size_t multiplier : MULTIPLIERS) {
+    spdlog::info("Testing {} with 2^{} * {} ({}) elements", name,
+                 INITIAL_CAPACITY_LOG2, multiplier,
+                 INITIAL_CAPACITY * multiplier);
+    benchmark_all(INITIAL_CAPACITY_LOG2, INITIAL_CAPACITY * multiplier);
+  }
+  spdlog::info("Benchmarking {} done.\n", name);
+
+  spdlog::info("Insertion throughput by load threshold (Mops):");
+  summarize(index_formatter, throughput_formatter);
+  std::cout << std::endl;
+
+  reset_benchmark({"DFF_80_BITS", "DFF_85_BITS", "DFF_90_BITS", "DFF_95_BITS",
+                   "DFF_ADAPTIVE_BITS"});
+  spdlog::info("Benchmarking {} memory usage...", name);
+  for (const size_t multiplier : MULTIPLIERS) {
+    spdlog::info("Testing {} memory usage with 2^{} * {} ({}) elements", name,
+                 INITIAL_CAPACITY_LOG2, multiplier,
+                 INITIAL_CAPACITY * multiplier);
+    benchmark_all(INITIAL_CAPACITY_LOG2, INITIAL_CAPACITY * multiplier);
+  }
+  spdlog::info("Benchmarking {} memory usage done.\n", name);
+
+  spdlog::info("Memory usage by load threshold (bits per item):");
+  summarize(index_formatter, multiply_formatter(1));
+}
+
+/* Alternative buckets anywhere in a segment, in the same cache line (8
+ * buckets) or in the same 4 KB page (512 buckets), see the tasks */
+BENCHMARK("alternate bucket") {
+  reset_benchmark({"DFF", "DFF_LINE", "DFF_PAGE"});
+  spdlog::info("Benchmarking {} insertion...", name);
+  for (const size_t multiplier : MULTIPLIERS) {
+    spdlog::info("Testing {} insertion with 2^{} * {} ({}) elements", name,
+                 INITIAL_CAPACITY_LOG2, multiplier,
+                 INITIAL_CAPACITY * multiplier);
+    benchmark_all(INITIAL_CAPACITY_LOG2, INITIAL_CAPACITY * multiplier);
+  }
+  spdlog::info("Benchmarking {} insertion done.\n", name);
+
+  spdlog::info("Insertion throughput by alternative bucket block (Mops):");
+  summarize(index_formatter, throughput_formatter);
+  std::cout << std::endl;
+
+  reset_benchmark({"DFF_NEG", "DFF_LINE_NEG", "DFF_PAGE_NEG"});
+  spdlog::info("Benchmarking {} negative query...", name);
+  for (const size_t multiplier : MULTIPLIERS) {
+    spdlog::info("Testing {} negative query with 2^{} * {} ({}) elements", name,
+                 INITIAL_CAPACITY_LOG2, multiplier,
+                 INITIAL_CAPACITY * multiplier);
+    benchmark_all(INITIAL_CAPACITY_LOG2, INITIAL_CAPACITY * multiplier);
+  }
+  spdlog::info("Benchmarking {} negative query done.\n", name);
+
+  spdlog::info("Negative query throughput by alternative bucket block (Mops):");
+  summarize(index_formatter, throughput_formatter);
+  std::cout << std::endl;
+
+  reset_benchmark({"DFF_FPR", "DFF_LINE_FPR", "DFF_PAGE_FPR"});
+  spdlog::info("Benchmarking {} false positive rate...", name);
+  for (const size_t multiplier : MULTIPLIERS) {
+    spdlog::info("Testing {} false positive rate with 2^{} * {} ({}) elements",
+                 name, INITIAL_CAPACITY_LOG2, multiplier,
+                 INITIAL_CAPACITY * multiplier);
+    benchmark_all(INITIAL_CAPACITY_LOG2, INITIAL_CAPACITY * multiplier);
+  }
+  spdlog::info("Benchmarking {} false positive rate done.\n", name);
+
+  spdlog::info("False positive rate by alternative bucket block (%):");
+  summarize(index_formatter, multiply_formatter(100));
+  std::cout << std::endl;
+
+  reset_benchmark({"DFF_LOAD", "DFF_LINE_LOAD", "DFF_PAGE_LOAD"});
+  spdlog::info("Benchmarking {} load factor...", name);
+  for (const size_t multiplier : MULTIPLIERS) {
+    spdlog::info("Testing {} load factor with 2^{} * {} ({}) elements", name,
+                 INITIAL_CAPACITY_LOG2, multiplier,
+                 INITIAL_CAPACITY * multiplier);
+    benchmark_all(INITIAL_CAPACITY_LOG2, INITIAL_CAPACITY * multiplier);
+  }
+  spdlog::info("Benchmarking {} load factor done.\n", name);
+
+  spdlog::info("Load factor by alternative bucket block (%):");
+  summarize(index_formatter, multiply_formatter(100));
+}
+
+/* Queries checking both buckets slot by slot, the primary bucket first, or
+ * both buckets without branching, see the tasks */
+BENCHMARK("query strategy") {
+  reset_benchmark({"DFF", "DFF_PRIMARY", "DFF_BRANCHLESS"});
+  spdlog::info("Benchmarking {} positive query...", name);
+  for (const size_t multiplier : MULTIPLIERS) {
+    spdlog::info("Testing {} positive query with 2^{} * {} ({}) elements", name,
+                 INITIAL_CAPACITY_LOG2, multiplier,
+                 INITIAL_CAPACITY * multiplier);
+    benchmark_all(INITIAL_CAPACITY_LOG2, INITIAL_CAPACITY * multiplier);
+  }
+  spdlog::info("Benchmarking {} positive query done.\n", name);
+
+  spdlog::info("Positive query throughput by query strategy (Mops):");
+  summarize(index_formatter, throughput_formatter);
+  std::cout << std::endl;
+
+  reset_benchmark({"DFF_NEG", "DFF_PRIMARY_NEG", "DFF_BRANCHLESS_NEG"});
+  spdlog::info("Benchmarking {} negative query...", name);
+  for (const size_t multiplier : MULTIPLIERS) {
+    spdlog::info("Testing {} negative query with 2^{} * {} ({}) elements", name,
+                 INITIAL_CAPACITY_LOG2, multiplier,
+                 INITIAL_CAPACITY * multiplier);
+    benchmark_all(INITIAL_CAPACITY_LOG2, INITIAL_CAPACITY * multiplier);
+  }
+  spdlog::info("Benchmarking {} negative query done.\n", name);
+
+  spdlog::info("Negative query throughput by query strategy (Mops):");
+  summarize(index_formatter, throughput_formatter);
+}
+
 /*******************
  * Addressing time *
  *******************/
@@ -284,6 +459,122 @@ BENCHMARK("expansion time") {
   summarize(index_formatter, multiply_formatter(1'000));
 }
 
+/*************************************
+ * Insertion throughput with the log *
+ *************************************/
+BENCHMARK("log insertion throughput") {
+  spdlog::info("Benchmarking {}...", name);
+  for (const size_t multiplier : MULTIPLIERS) {
+    spdlog::info("Testing {} with 2^{} * {} ({}) elements", name,
+                 INITIAL_CAPACITY_LOG2, multiplier,
+                 INITIAL_CAPACITY * multiplier);
+    benchmark_all(INITIAL_CAPACITY_LOG2, INITIAL_CAPACITY * multiplier);
+  }
+  spdlog::info("Benchmarking {} done.\n", name);
+
+  spdlog::info("Insertion throughput by log sync interval (Mops):");
+  summarize(index_formatter, throughput_formatter);
+}
+
+/**************
+ * Clone time *
+ **************/
+BENCHMARK("clone time") {
+  spdlog::info("Benchmarking {}...", name);
+  for (const size_t multiplier : MULTIPLIERS) {
+    spdlog::info("Testing {} with 2^{} * {} ({}) elements", name,
+                 INITIAL_CAPACITY_LOG2, multiplier,
+                 INITIAL_CAPACITY * multiplier);
+    benchmark_all(INITIAL_CAPACITY_LOG2, INITIAL_CAPACITY * multiplier);
+  }
+  spdlog::info("Benchmarking {} done.\n", name);
+
+  spdlog::info("Clone time compared with rebuild time (ms):");
+  summarize(index_formatter, multiply_formatter(1'000));
+}
+
+/*************
+ * Load time *
+ *************/
+BENCHMARK("load time") {
+  spdlog::info("Benchmarking {}...", name);
+  for (const size_t multiplier : MULTIPLIERS) {
+    spdlog::info("Testing {} with 2^{} * {} ({}) elements", name,
+                 INITIAL_CAPACITY_LOG2, multiplier,
+                 INITIAL_CAPACITY * multiplier);
+    benchmark_all(INITIAL_CAPACITY_LOG2, INITIAL_CAPACITY * multiplier);
+  }
+  spdlog::info("Benchmarking {} done.\n", name);
+
+  spdlog::info("Load time compared with rebuild time (ms):");
+  summarize(index_formatter, multiply_formatter(1'000));
+}
+
+/**************
+ * Merge time *
+ **************/
+BENCHMARK("merge time") {
+  spdlog::info("Benchmarking {}...", name);
+  for (const size_t multiplier : MULTIPLIERS) {
+    spdlog::info("Testing {} with 2^{} * {} ({}) elements", name,
+                 INITIAL_CAPACITY_LOG2, multiplier,
+                 INITIAL_CAPACITY * multiplier);
+    benchmark_all(INITIAL_CAPACITY_LOG2, INITIAL_CAPACITY * multiplier);
+  }
+  spdlog::info("Benchmarking {} done.\n", name);
+
+  spdlog::info("Merge time compared with reinsertion time (ms):");
+  summarize(index_formatter, multiply_formatter(1'000));
+}
+
+/*************
+ * Snapshots *
+ *************/
+BENCHMARK("snapshot insertion time") {
+  spdlog::info("Benchmarking {}...", name);
+  for (const size_t multiplier : MULTIPLIERS) {
+    spdlog::info("Testing {} with 2^{} * {} ({}) elements", name,
+                 INITIAL_CAPACITY_LOG2, multiplier,
+                 INITIAL_CAPACITY * multiplier);
+    benchmark_all(INITIAL_CAPACITY_LOG2, INITIAL_CAPACITY * multiplier);
+  }
+  spdlog::info("Benchmarking {} done.\n", name);
+
+  spdlog::info("Insertion time holding a snapshot (ms):");
+  summarize(index_formatter, multiply_formatter(1'000));
+}
+
+BENCHMARK("snapshot memory overhead") {
+  spdlog::info("Benchmarking {}...", name);
+  for (const size_t multiplier : MULTIPLIERS) {
+    spdlog::info("Testing {} with 2^{} * {} ({}) elements", name,
+                 INITIAL_CAPACITY_LOG2, multiplier,
+                 INITIAL_CAPACITY * multiplier);
+    benchmark_all(INITIAL_CAPACITY_LOG2, INITIAL_CAPACITY * multiplier);
+  }
+  spdlog::info("Benchmarking {} done.\n", name);
+
+  spdlog::info("Snapshot memory by writes after it (% of filter):");
+  summarize(index_formatter, multiply_formatter(100));
+}
+
+/********************************
+ * File-backed query throughput *
+ ********************************/
+BENCHMARK("file backed query throughput") {
+  spdlog::info("Benchmarking {}...", name);
+  for (const size_t multiplier : MULTIPLIERS) {
+    spdlog::info("Testing {} with 2^{} * {} ({}) elements", name,
+                 INITIAL_CAPACITY_LOG2, multiplier,
+                 INITIAL_CAPACITY * multiplier);
+    benchmark_all(INITIAL_CAPACITY_LOG2, INITIAL_CAPACITY * multiplier);
+  }
+  spdlog::info("Benchmarking {} done.\n", name);
+
+  spdlog::info("Positive query throughput by memory limit (Mops):");
+  summarize(index_formatter, throughput_formatter);
+}
+
 /***********************
  * False positive rate *
  ***********************/
@@ -301,6 +592,20 @@ BENCHMARK("false positive rate") {
   summarize(index_formatter, multiply_formatter(100));
 }
 
+BENCHMARK("budget false positive rate") {
+  spdlog::info("Benchmarking {}...", name);
+  for (const size_t multiplier : MULTIPLIERS) {
+    spdlog::info("Testing {} with 2^{} * {} ({}) elements", name,
+                 INITIAL_CAPACITY_LOG2, multiplier,
+                 INITIAL_CAPACITY * multiplier);
+    benchmark_all(INITIAL_CAPACITY_LOG2, INITIAL_CAPACITY * multiplier);
+  }
+  spdlog::info("Benchmarking {} done.\n", name);
+
+  spdlog::info("False positive rate under a memory budget (%):");
+  summarize(index_formatter, multiply_formatter(100));
+}
+
 /********************************************
  * Space usage (Memory efficiency in paper) *
  ********************************************/
@@ -314,6 +619,39 @@ BENCHMARK("space usage") {
 
   spdlog::info("Space usage (MB):");
   summarize(index_formatter, multiply_formatter(1 / (8.0 * 1024 * 1024)));
+  spdlog::info("Space usage (bits per item):");
+  summarize(index_formatter, per_item_formatter);
+}
+
+/*****************************************************
+ * Space usage after deletions (Memory reclamation) *
+ *****************************************************/
+BENCHMARK("deletion space usage") {
+  spdlog::info("Benchmarking {}...", name);
+  for (const size_t multiplier : MULTIPLIERS) {
+    spdlog::info("Testing {} with 2^{} * {} ({}) elements", name,
+                 INITIAL_CAPACITY_LOG2, multiplier,
+                 INITIAL_CAPACITY * multiplier);
+    benchmark_all(INITIAL_CAPACITY_LOG2, INITIAL_CAPACITY * multiplier);
+  }
+  spdlog::info("Benchmarking {} done.\n", name);
+
+  spdlog::info("Resident memory after deleting 90% of the elements (MB):");
+  summarize(index_formatter, multiply_formatter(1 / (1024.0 * 1024)));
+}
+
+BENCHMARK("shrink execution time") {
+  spdlog::info("Benchmarking {}...", name);
+  for (const size_t multiplier : MULTIPLIERS) {
+    spdlog::info("Testing {} with 2^{} * {} ({}) elements", name,
+                 INITIAL_CAPACITY_LOG2, multiplier,
+                 INITIAL_CAPACITY * multiplier);
+    benchmark_all(INITIAL_CAPACITY_LOG2, INITIAL_CAPACITY * multiplier);
+  }
+  spdlog::info("Benchmarking {} done.\n", name);
+
+  spdlog::info("Execution total time with 3 deletion/reinsertion waves (ms):");
+  summarize(index_formatter, multiply_formatter(1'000));
 }
 
 /********************************************
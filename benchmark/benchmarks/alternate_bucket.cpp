@@ -0,0 +1,97 @@
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include <fmt/core.h>
+
+#include "../../src/DFF.hpp"
+#include "benchmark_utils.hpp"
+
+// Alternative buckets anywhere in the segment if `BLOCK_BUCKETS` is 0, otherwise in the same block
+// of `BLOCK_BUCKETS` buckets (8 buckets of 16-bit tags make a cache line, 512 a 4 KB page)
+template <size_t BLOCK_BUCKETS>
+using Filter = dff::DFF<uint64_t, false, dff::BlockedConfig<BLOCK_BUCKETS>>;
+
+template <size_t BLOCK_BUCKETS>
+void insert_all(Filter<BLOCK_BUCKETS> &filter, const uint64_t *nums, const size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    if (filter.insert(nums[i]) != dff::Ok) {
+      const std::string msg = fmt::format(
+          "Insertion failed: Unable to insert element {} at index {}/{}", nums[i], i, n - 1);
+      throw std::runtime_error(msg);
+    }
+  }
+}
+
+// Insertion time
+template <size_t BLOCK_BUCKETS>
+auto measure_insertion_time(const uint64_t *nums, const size_t n) -> double {
+  Filter<BLOCK_BUCKETS> filter(16);
+  const double start = get_current_time_in_seconds();
+  insert_all(filter, nums, n);
+  return get_current_time_in_seconds() - start;
+}
+
+// Negative query time
+template <size_t BLOCK_BUCKETS>
+auto measure_negative_query_time(const uint64_t *nums, const size_t n) -> double {
+  Filter<BLOCK_BUCKETS> filter(16);
+  insert_all(filter, nums, n);
+  size_t false_positive_count = 0;
+  const double start = get_current_time_in_seconds();
+  for (size_t i = 0; i < n; i++)
+    if (filter.query(nums[n + i]) == dff::Ok)
+      false_positive_count++;
+  const double end = get_current_time_in_seconds();
+  if (false_positive_count == 0)
+    throw std::runtime_error("Query failed: should have some false positives, but none found");
+  return end - start;
+}
+
+// False positive rate
+template <size_t BLOCK_BUCKETS>
+auto measure_false_positive_rate(const uint64_t *nums, const size_t n) -> double {
+  Filter<BLOCK_BUCKETS> filter(16);
+  insert_all(filter, nums, n);
+  size_t false_positive_count = 0;
+  for (size_t i = 0; i < n; i++)
+    if (filter.query(nums[n + i]) == dff::Ok)
+      false_positive_count++;
+  return static_cast<double>(false_positive_count) / static_cast<double>(n);
+}
+
+// Load factor (items per slot)
+template <size_t BLOCK_BUCKETS>
+auto measure_load_factor(const uint64_t *nums, const size_t n) -> double {
+  Filter<BLOCK_BUCKETS> filter(16);
+  insert_all(filter, nums, n);
+  return static_cast<double>(n) /
+         static_cast<double>(filter.num_seg * dff::BUCKETS_PER_SEG * dff::SLOTS_PER_BUCKET);
+}
+
+REGISTER_BENCHMARK_TASK(DFF) { return measure_insertion_time<0>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(DFF_LINE) { return measure_insertion_time<8>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(DFF_PAGE) { return measure_insertion_time<512>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(DFF_NEG) { return measure_negative_query_time<0>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(DFF_LINE_NEG) { return measure_negative_query_time<8>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(DFF_PAGE_NEG) { return measure_negative_query_time<512>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(DFF_FPR) { return measure_false_positive_rate<0>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(DFF_LINE_FPR) { return measure_false_positive_rate<8>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(DFF_PAGE_FPR) { return measure_false_positive_rate<512>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(DFF_LOAD) { return measure_load_factor<0>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(DFF_LINE_LOAD) { return measure_load_factor<8>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(DFF_PAGE_LOAD) { return measure_load_factor<512>(nums, n); }
+
+BENCHMARK_TASK_MAIN
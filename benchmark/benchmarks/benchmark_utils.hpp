@@ -3,11 +3,19 @@
 #include <algorithm>
 #include <chrono>
 #include <cstdint>
+#include <fstream>
 #include <functional>
 #include <iostream>
 #include <random>
 #include <string>
 
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
 #include <fmt/core.h>
 #include <fplus/fplus.hpp>
 
@@ -32,6 +40,27 @@ inline auto get_current_time_in_seconds() -> double {
   return std::chrono::duration_cast<std::chrono::duration<double>>(duration).count();
 }
 
+/**
+ * @brief Get the resident set size of the current process. Free heap memory is given back to the
+ * OS first (on glibc), so that memory freed by a filter is not counted.
+ *
+ * @return The resident set size in bytes, or 0 if not supported on the platform.
+ */
+inline auto get_resident_memory_in_bytes() -> size_t {
+#ifdef __GLIBC__
+  malloc_trim(0);
+#endif
+#ifdef __linux__
+  std::ifstream statm("/proc/self/statm");
+  size_t total_pages = 0;
+  size_t resident_pages = 0;
+  statm >> total_pages >> resident_pages;
+  return resident_pages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#else
+  return 0;
+#endif
+}
+
 inline void random_gen(uint64_t *nums, const size_t n) {
   std::mt19937_64 gen(std::random_device{}());
   std::uniform_int_distribution<uint64_t> dis(0, std::numeric_limits<uint64_t>::max());
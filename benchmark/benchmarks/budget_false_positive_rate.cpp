@@ -0,0 +1,65 @@
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+#include <fmt/core.h>
+
+#include "../../src/DFF.hpp"
+#include "benchmark_utils.hpp"
+
+// Fixed memory budget of the filters, reached at about half of the largest benchmarked scale
+constexpr size_t MEMORY_BUDGET = 8UZ * 1024 * 1024;
+
+template <bool ENABLE_FINGERPRINT_GROWTH>
+auto measure_false_positive_rate(const uint64_t *nums, const size_t n, const bool predicted)
+    -> double {
+  dff::DFF<uint64_t, ENABLE_FINGERPRINT_GROWTH> filter(16);
+  filter.set_memory_budget(MEMORY_BUDGET);
+
+  for (size_t i = 0; i < n; i++) {
+    if (filter.insert(nums[i]) != dff::Ok) {
+      const std::string msg = fmt::format(
+          "Insertion failed: Unable to insert element {} at index {}/{}", nums[i], i, n - 1);
+      throw std::runtime_error(msg);
+    }
+  }
+
+  // Make sure no false negative happens
+  for (size_t i = 0; i < n; i++) {
+    if (filter.query(nums[i]) != dff::Ok) {
+      const std::string msg =
+          fmt::format("Query failed (false negative): Unable to find element {} at index {}/{}",
+                      nums[i], i, n - 1);
+      throw std::runtime_error(msg);
+    }
+  }
+
+  if (filter.memory_usage() > MEMORY_BUDGET) {
+    const std::string msg = fmt::format("Memory budget exceeded: {} > {} bytes",
+                                        filter.memory_usage(), MEMORY_BUDGET);
+    throw std::runtime_error(msg);
+  }
+
+  if (predicted)
+    return filter.predicted_false_positive_rate();
+
+  size_t false_positive_count = 0;
+  for (size_t i = 0; i < n; i++) {
+    if (filter.query(nums[n + i]) == dff::Ok) {
+      false_positive_count++;
+    }
+  }
+  return static_cast<double>(false_positive_count) / static_cast<double>(n);
+}
+
+REGISTER_BENCHMARK_TASK(DFF) { return measure_false_positive_rate<false>(nums, n, false); }
+
+REGISTER_BENCHMARK_TASK(DFF_FG) { return measure_false_positive_rate<true>(nums, n, false); }
+
+REGISTER_BENCHMARK_TASK(DFF_PREDICTED) { return measure_false_positive_rate<false>(nums, n, true); }
+
+REGISTER_BENCHMARK_TASK(DFF_FG_PREDICTED) {
+  return measure_false_positive_rate<true>(nums, n, true);
+}
+
+BENCHMARK_TASK_MAIN
@@ -0,0 +1,67 @@
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+#include <fmt/core.h>
+
+#include "../../src/DFF.hpp"
+#include "benchmark_utils.hpp"
+
+template <bool ENABLE_FINGERPRINT_GROWTH>
+void build(dff::DFF<uint64_t, ENABLE_FINGERPRINT_GROWTH> &filter, const uint64_t *nums,
+           const size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    if (filter.insert(nums[i]) != dff::Ok) {
+      const std::string msg =
+          fmt::format("Insertion failed: Unable to insert {} at index {}/{}", nums[i], i, n - 1);
+      throw std::runtime_error(msg);
+    }
+  }
+}
+
+template <bool ENABLE_FINGERPRINT_GROWTH>
+void check_no_false_negative(dff::DFF<uint64_t, ENABLE_FINGERPRINT_GROWTH> &filter,
+                             const uint64_t *nums, const size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    if (filter.query(nums[i]) != dff::Ok) {
+      const std::string msg =
+          fmt::format("Query failed (false negative): Unable to find element {} at index {}/{}",
+                      nums[i], i, n - 1);
+      throw std::runtime_error(msg);
+    }
+  }
+}
+
+template <bool ENABLE_FINGERPRINT_GROWTH>
+auto measure_clone_time(const uint64_t *nums, const size_t n) -> double {
+  dff::DFF<uint64_t, ENABLE_FINGERPRINT_GROWTH> filter(16);
+  build(filter, nums, n);
+
+  const double start = get_current_time_in_seconds();
+  auto clone = filter.clone();
+  const double end = get_current_time_in_seconds();
+
+  check_no_false_negative(clone, nums, n);
+  return end - start;
+}
+
+template <bool ENABLE_FINGERPRINT_GROWTH>
+auto measure_rebuild_time(const uint64_t *nums, const size_t n) -> double {
+  const double start = get_current_time_in_seconds();
+  dff::DFF<uint64_t, ENABLE_FINGERPRINT_GROWTH> filter(16);
+  build(filter, nums, n);
+  const double end = get_current_time_in_seconds();
+
+  check_no_false_negative(filter, nums, n);
+  return end - start;
+}
+
+REGISTER_BENCHMARK_TASK(DFF) { return measure_clone_time<false>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(DFF_FG) { return measure_clone_time<true>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(DFF_REBUILD) { return measure_rebuild_time<false>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(DFF_FG_REBUILD) { return measure_rebuild_time<true>(nums, n); }
+
+BENCHMARK_TASK_MAIN
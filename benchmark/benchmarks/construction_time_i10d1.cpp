@@ -66,6 +66,62 @@ REGISTER_BENCHMARK_TASK(DFF_FG) {
   return end - start;
 }
 
+REGISTER_BENCHMARK_TASK(DFF_RESERVED) {
+  dff::DFF<uint64_t, false> filter(16);
+
+  int flag = 0;
+  const double start = get_current_time_in_seconds();
+  if (filter.reserve(n) != dff::Ok)
+    throw std::runtime_error("Reservation failed: Unable to reserve space for all elements");
+  for (size_t i = 0; i < n; i++) {
+    if (filter.insert(nums[i]) != dff::Ok) {
+      const std::string msg =
+          fmt::format("Insertion failed: Unable to insert {} at index {}/{}", nums[i], i, n - 1);
+      throw std::runtime_error(msg);
+    }
+    flag++;
+    if (flag == 10) {
+      if (filter.remove(nums[i]) != dff::Ok) {
+        const std::string msg =
+            fmt::format("Deletion failed: Unable to delete {} at index {}/{}", nums[i], i, n - 1);
+        throw std::runtime_error(msg);
+      }
+      flag = 0;
+    }
+  }
+
+  const double end = get_current_time_in_seconds();
+  return end - start;
+}
+
+REGISTER_BENCHMARK_TASK(DFF_FG_RESERVED) {
+  dff::DFF<uint64_t, true> filter(16);
+
+  int flag = 0;
+  const double start = get_current_time_in_seconds();
+  if (filter.reserve(n) != dff::Ok)
+    throw std::runtime_error("Reservation failed: Unable to reserve space for all elements");
+  for (size_t i = 0; i < n; i++) {
+    if (filter.insert(nums[i]) != dff::Ok) {
+      const std::string msg =
+          fmt::format("Insertion failed: Unable to insert {} at index {}/{}", nums[i], i, n - 1);
+      throw std::runtime_error(msg);
+    }
+    flag++;
+    if (flag == 10) {
+      if (filter.remove(nums[i]) != dff::Ok) {
+        const std::string msg =
+            fmt::format("Deletion failed: Unable to delete {} at index {}/{}", nums[i], i, n - 1);
+        throw std::runtime_error(msg);
+      }
+      flag = 0;
+    }
+  }
+
+  const double end = get_current_time_in_seconds();
+  return end - start;
+}
+
 REGISTER_BENCHMARK_TASK(IFF) {
   infinifilter::ChainedInfiniFilter filter(6, 16 + /* flag bits */ 3);
 
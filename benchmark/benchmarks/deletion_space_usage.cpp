@@ -0,0 +1,118 @@
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+#include <fmt/core.h>
+
+#include "../../src/DFF.hpp"
+#include "../impl/bamboofilter/bamboofilter.hpp"
+#include "benchmark_utils.hpp"
+
+// Fraction of the inserted elements kept after the deletion wave
+constexpr size_t KEEP_DIVISOR = 10;
+
+REGISTER_BENCHMARK_TASK(DFF) {
+  const size_t start_memory = get_resident_memory_in_bytes();
+
+  dff::DFF<uint64_t, false> filter(16);
+
+  for (size_t i = 0; i < n; i++) {
+    if (filter.insert(nums[i]) != dff::Ok) {
+      const std::string msg =
+          fmt::format("Insertion failed: Unable to insert {} at index {}/{}", nums[i], i, n - 1);
+      throw std::runtime_error(msg);
+    }
+  }
+
+  for (size_t i = n / KEEP_DIVISOR; i < n; i++) {
+    if (filter.remove(nums[i]) != dff::Ok) {
+      const std::string msg =
+          fmt::format("Deletion failed: Unable to delete {} at index {}/{}", nums[i], i, n - 1);
+      throw std::runtime_error(msg);
+    }
+  }
+  filter.compact();
+
+  // Make sure no false negative happens
+  for (size_t i = 0; i < n / KEEP_DIVISOR; i++) {
+    if (filter.query(nums[i]) != dff::Ok) {
+      const std::string msg =
+          fmt::format("Query failed (false negative): Unable to find element {} at index {}/{}",
+                      nums[i], i, n - 1);
+      throw std::runtime_error(msg);
+    }
+  }
+
+  return static_cast<double>(get_resident_memory_in_bytes()) - static_cast<double>(start_memory);
+}
+
+REGISTER_BENCHMARK_TASK(DFF_FG) {
+  const size_t start_memory = get_resident_memory_in_bytes();
+
+  dff::DFF<uint64_t, true> filter(16);
+
+  for (size_t i = 0; i < n; i++) {
+    if (filter.insert(nums[i]) != dff::Ok) {
+      const std::string msg =
+          fmt::format("Insertion failed: Unable to insert {} at index {}/{}", nums[i], i, n - 1);
+      throw std::runtime_error(msg);
+    }
+  }
+
+  for (size_t i = n / KEEP_DIVISOR; i < n; i++) {
+    if (filter.remove(nums[i]) != dff::Ok) {
+      const std::string msg =
+          fmt::format("Deletion failed: Unable to delete {} at index {}/{}", nums[i], i, n - 1);
+      throw std::runtime_error(msg);
+    }
+  }
+  filter.compact();
+
+  // Make sure no false negative happens
+  for (size_t i = 0; i < n / KEEP_DIVISOR; i++) {
+    if (filter.query(nums[i]) != dff::Ok) {
+      const std::string msg =
+          fmt::format("Query failed (false negative): Unable to find element {} at index {}/{}",
+                      nums[i], i, n - 1);
+      throw std::runtime_error(msg);
+    }
+  }
+
+  return static_cast<double>(get_resident_memory_in_bytes()) - static_cast<double>(start_memory);
+}
+
+REGISTER_BENCHMARK_TASK(BBF) {
+  const size_t start_memory = get_resident_memory_in_bytes();
+
+  bamboofilter::BambooFilter<uint64_t> filter(initial_capacity, 4);
+
+  for (size_t i = 0; i < n; i++) {
+    if (!filter.Insert(nums[i])) {
+      const std::string msg =
+          fmt::format("Insertion failed: Unable to insert {} at index {}/{}", nums[i], i, n - 1);
+      throw std::runtime_error(msg);
+    }
+  }
+
+  for (size_t i = n / KEEP_DIVISOR; i < n; i++) {
+    if (!filter.Delete(nums[i])) {
+      const std::string msg =
+          fmt::format("Deletion failed: Unable to delete {} at index {}/{}", nums[i], i, n - 1);
+      throw std::runtime_error(msg);
+    }
+  }
+
+  // Make sure no false negative happens
+  for (size_t i = 0; i < n / KEEP_DIVISOR; i++) {
+    if (!filter.Lookup(nums[i])) {
+      const std::string msg =
+          fmt::format("Query failed (false negative): Unable to find element {} at index {}/{}",
+                      nums[i], i, n - 1);
+      throw std::runtime_error(msg);
+    }
+  }
+
+  return static_cast<double>(get_resident_memory_in_bytes()) - static_cast<double>(start_memory);
+}
+
+BENCHMARK_TASK_MAIN
@@ -12,7 +12,7 @@
 #include "benchmark_utils.hpp"
 
 REGISTER_BENCHMARK_TASK(DFF) {
-  dff::DFF<uint64_t, false, true> filter(16);
+  dff::DFF<uint64_t, false, dff::DefaultConfig, true> filter(16);
 
   for (size_t i = 0; i < n; i++) {
     if (filter.insert(nums[i]) != dff::Ok) {
@@ -26,7 +26,7 @@ REGISTER_BENCHMARK_TASK(DFF) {
 }
 
 REGISTER_BENCHMARK_TASK(DFF_FG) {
-  dff::DFF<uint64_t, true, true> filter(16);
+  dff::DFF<uint64_t, true, dff::DefaultConfig, true> filter(16);
 
   for (size_t i = 0; i < n; i++) {
     if (filter.insert(nums[i]) != dff::Ok) {
@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+
+#include <fmt/core.h>
+
+#include "../../src/DFF.hpp"
+#include "benchmark_utils.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+
+// A query reads two buckets, each of which may straddle two pages
+constexpr size_t PAGES_PER_QUERY = 4;
+
+// Query with the segment tables in a mapped file, of which at most `1 / OVERSUBSCRIPTION` may be
+// resident, i.e., the filter is `OVERSUBSCRIPTION` times the memory limit (1 for no limit).
+// Unprivileged processes cannot limit their page cache (`RLIMIT_RSS` is not enforced on Linux and
+// cgroups need privileges), so the limit is enforced by evicting the file after every batch of
+// queries that could have paged in the allowed memory.
+template <size_t OVERSUBSCRIPTION>
+auto measure_query_time(const uint64_t *nums, const size_t n) -> double {
+  const auto path = (std::filesystem::temp_directory_path() /
+                     fmt::format("dff_arena_{}_{}.bin", OVERSUBSCRIPTION, ::getpid()))
+                        .string();
+  // Small chunks, so that the file is not much larger than the tables
+  MappedFileArena arena(1UZ << 20);
+  if (!arena.open(path))
+    throw std::runtime_error(fmt::format("Unable to create the file {}", path));
+  std::filesystem::remove(path);
+  dff::DFF<uint64_t, false> filter(16, &arena);
+
+  // Insert
+  for (size_t i = 0; i < n; i++) {
+    if (filter.insert(nums[i]) != dff::Ok) {
+      const std::string msg = fmt::format(
+          "Insertion failed: Unable to insert element {} at index {}/{}", nums[i], i, n - 1);
+      throw std::runtime_error(msg);
+    }
+  }
+
+  const auto page_size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+  // The limit only covers the tables: the lookup table and the segment headers stay on the heap,
+  // but are a few hundred bytes per segment, against tens of kilobytes for its table
+  const size_t memory_limit = arena.file_size() / OVERSUBSCRIPTION;
+  const size_t queries_per_eviction =
+      std::max<size_t>(memory_limit / page_size / PAGES_PER_QUERY, 1);
+  if (OVERSUBSCRIPTION > 1 && !arena.evict())
+    throw std::runtime_error("Unable to evict the file");
+
+  // Test positive query
+  const double start = get_current_time_in_seconds();
+  for (size_t i = 0; i < n; i++) {
+    if (OVERSUBSCRIPTION > 1 && i % queries_per_eviction == queries_per_eviction - 1 &&
+        !arena.evict())
+      throw std::runtime_error("Unable to evict the file");
+    if (filter.query(nums[i]) != dff::Ok) {
+      const std::string msg =
+          fmt::format("Query failed (false negative): Unable to find element {} at index {}/{}",
+                      nums[i], i, n - 1);
+      throw std::runtime_error(msg);
+    }
+  }
+  const double end = get_current_time_in_seconds();
+
+  return end - start;
+}
+
+REGISTER_BENCHMARK_TASK(DFF) {
+  dff::DFF<uint64_t, false> filter(16);
+
+  // Insert
+  for (size_t i = 0; i < n; i++) {
+    if (filter.insert(nums[i]) != dff::Ok) {
+      const std::string msg = fmt::format(
+          "Insertion failed: Unable to insert element {} at index {}/{}", nums[i], i, n - 1);
+      throw std::runtime_error(msg);
+    }
+  }
+
+  // Test positive query
+  const double start = get_current_time_in_seconds();
+  for (size_t i = 0; i < n; i++) {
+    if (filter.query(nums[i]) != dff::Ok) {
+      const std::string msg =
+          fmt::format("Query failed (false negative): Unable to find element {} at index {}/{}",
+                      nums[i], i, n - 1);
+      throw std::runtime_error(msg);
+    }
+  }
+  const double end = get_current_time_in_seconds();
+
+  return end - start;
+}
+
+REGISTER_BENCHMARK_TASK(DFF_FILE) { return measure_query_time<1>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(DFF_FILE_2X_MEMORY_LIMIT) { return measure_query_time<2>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(DFF_FILE_4X_MEMORY_LIMIT) { return measure_query_time<4>(nums, n); }
+#endif
+
+BENCHMARK_TASK_MAIN
@@ -0,0 +1,128 @@
+#include <cstddef>
+#include <cstdint>
+#include <random>
+
+#include "../../src/segment.hpp"
+#include "benchmark_utils.hpp"
+
+// Here `n` is not a number of elements but the load (in percent) reached by the measured
+// insertions, which fill the last 5% of slots of each segment below it
+constexpr size_t SEGMENT_COUNT = 64;
+constexpr size_t SLOTS_PER_SEG = dff::BUCKETS_PER_SEG * dff::SLOTS_PER_BUCKET;
+constexpr size_t MEASURED_LOAD_PERCENT = 5;
+constexpr size_t MEASURED_PER_SEG = SLOTS_PER_SEG * MEASURED_LOAD_PERCENT / 100;
+
+template <bool ENABLE_FINGERPRINT_GROWTH, typename Config>
+auto insert_num(dff::Segment<uint64_t, ENABLE_FINGERPRINT_GROWTH, Config> &seg, const uint64_t num)
+    -> dff::Status {
+  return seg.insert(num & (dff::BUCKETS_PER_SEG - 1), static_cast<uint32_t>(num >> 32));
+}
+
+// Fill segments to `load_percent - MEASURED_LOAD_PERCENT`%, then insert up to `load_percent`%.
+// Returns the time spent in the measured insertions, or counts them by number of kicks in
+// `kick_counts` (the last entry for failed insertions) instead if not `nullptr`.
+template <bool ENABLE_FINGERPRINT_GROWTH, typename Config = dff::DefaultConfig>
+auto measure_high_load_insertion(const uint64_t *nums, const size_t load_percent,
+                                 size_t *kick_counts) -> double {
+  std::mt19937_64 gen(nums[0]);
+  const size_t filled = SLOTS_PER_SEG * (load_percent - MEASURED_LOAD_PERCENT) / 100;
+  double time = 0.0;
+
+  for (size_t i = 0; i < SEGMENT_COUNT; i++) {
+    dff::Segment<uint64_t, ENABLE_FINGERPRINT_GROWTH, Config> seg(dff::BUCKETS_PER_SEG, 16, 16);
+    for (size_t j = 0; j < filled; j++)
+      insert_num(seg, gen());
+
+    if (kick_counts == nullptr) {
+      const double start = get_current_time_in_seconds();
+      for (size_t j = 0; j < MEASURED_PER_SEG; j++)
+        insert_num(seg, gen());
+      time += get_current_time_in_seconds() - start;
+    } else {
+      for (size_t j = 0; j < MEASURED_PER_SEG; j++) {
+        const uint64_t kicks = seg.num_kicks;
+        if (insert_num(seg, gen()) != dff::Ok)
+          kick_counts[dff::K_MAX_KICK_COUNT + 1]++;
+        else
+          kick_counts[seg.num_kicks - kicks]++;
+      }
+    }
+  }
+
+  return time;
+}
+
+// Fraction of the measured insertions that move `KICKS` tags, or fail if `KICKS` is greater than
+// `K_MAX_KICK_COUNT`
+template <size_t KICKS, typename Config = dff::DefaultConfig>
+auto measure_kick_fraction(const uint64_t *nums, const size_t n) -> double {
+  size_t kick_counts[dff::K_MAX_KICK_COUNT + 2]{};
+  measure_high_load_insertion<false, Config>(nums, n, kick_counts);
+  size_t total = 0;
+  for (const size_t count : kick_counts)
+    total += count;
+  return static_cast<double>(kick_counts[KICKS]) / static_cast<double>(total);
+}
+
+// Insertion throughput (ops/s)
+template <bool ENABLE_FINGERPRINT_GROWTH, typename Config = dff::DefaultConfig>
+auto measure_throughput(const uint64_t *nums, const size_t n) -> double {
+  return static_cast<double>(SEGMENT_COUNT * MEASURED_PER_SEG) /
+         measure_high_load_insertion<ENABLE_FINGERPRINT_GROWTH, Config>(nums, n, nullptr);
+}
+
+REGISTER_BENCHMARK_TASK(DFF) { return measure_throughput<false>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(DFF_FG) { return measure_throughput<true>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(DFF_2C) { return measure_throughput<false, dff::TwoChoiceConfig>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(DFF_FG_2C) {
+  return measure_throughput<true, dff::TwoChoiceConfig>(nums, n);
+}
+
+REGISTER_BENCHMARK_TASK(KICKS_0) { return measure_kick_fraction<0>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(KICKS_1) { return measure_kick_fraction<1>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(KICKS_2) { return measure_kick_fraction<2>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(KICKS_3) { return measure_kick_fraction<3>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(KICKS_4) { return measure_kick_fraction<4>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(KICKS_5) { return measure_kick_fraction<5>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(FAILED) {
+  return measure_kick_fraction<dff::K_MAX_KICK_COUNT + 1>(nums, n);
+}
+
+REGISTER_BENCHMARK_TASK(KICKS_0_2C) {
+  return measure_kick_fraction<0, dff::TwoChoiceConfig>(nums, n);
+}
+
+REGISTER_BENCHMARK_TASK(KICKS_1_2C) {
+  return measure_kick_fraction<1, dff::TwoChoiceConfig>(nums, n);
+}
+
+REGISTER_BENCHMARK_TASK(KICKS_2_2C) {
+  return measure_kick_fraction<2, dff::TwoChoiceConfig>(nums, n);
+}
+
+REGISTER_BENCHMARK_TASK(KICKS_3_2C) {
+  return measure_kick_fraction<3, dff::TwoChoiceConfig>(nums, n);
+}
+
+REGISTER_BENCHMARK_TASK(KICKS_4_2C) {
+  return measure_kick_fraction<4, dff::TwoChoiceConfig>(nums, n);
+}
+
+REGISTER_BENCHMARK_TASK(KICKS_5_2C) {
+  return measure_kick_fraction<5, dff::TwoChoiceConfig>(nums, n);
+}
+
+REGISTER_BENCHMARK_TASK(FAILED_2C) {
+  return measure_kick_fraction<dff::K_MAX_KICK_COUNT + 1, dff::TwoChoiceConfig>(nums, n);
+}
+
+BENCHMARK_TASK_MAIN
@@ -0,0 +1,70 @@
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include <fmt/core.h>
+
+#include "../../src/DFF.hpp"
+#include "benchmark_utils.hpp"
+
+// A filter with a load threshold of `LOAD_THRESHOLD_PERCENT`%, or with adaptive expansion if 0
+template <size_t LOAD_THRESHOLD_PERCENT> auto make_filter() -> dff::DFF<uint64_t, false> {
+  dff::DFF<uint64_t, false> filter(16);
+  const dff::Status res = LOAD_THRESHOLD_PERCENT == 0
+                              ? filter.set_adaptive_expansion(true)
+                              : filter.set_load_threshold(LOAD_THRESHOLD_PERCENT / 100.0);
+  if (res != dff::Ok)
+    throw std::runtime_error(
+        fmt::format("Unable to set the load threshold to {}%", LOAD_THRESHOLD_PERCENT));
+  return filter;
+}
+
+void insert_all(dff::DFF<uint64_t, false> &filter, const uint64_t *nums, const size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    if (filter.insert(nums[i]) != dff::Ok) {
+      const std::string msg = fmt::format(
+          "Insertion failed: Unable to insert element {} at index {}/{}", nums[i], i, n - 1);
+      throw std::runtime_error(msg);
+    }
+  }
+}
+
+// Insertion time
+template <size_t LOAD_THRESHOLD_PERCENT>
+auto measure_insertion_time(const uint64_t *nums, const size_t n) -> double {
+  auto filter = make_filter<LOAD_THRESHOLD_PERCENT>();
+  const double start = get_current_time_in_seconds();
+  insert_all(filter, nums, n);
+  return get_current_time_in_seconds() - start;
+}
+
+// Memory used per item (bits)
+template <size_t LOAD_THRESHOLD_PERCENT>
+auto measure_bits_per_item(const uint64_t *nums, const size_t n) -> double {
+  auto filter = make_filter<LOAD_THRESHOLD_PERCENT>();
+  insert_all(filter, nums, n);
+  return static_cast<double>(filter.memory_usage() * 8) / static_cast<double>(n);
+}
+
+REGISTER_BENCHMARK_TASK(DFF_80) { return measure_insertion_time<80>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(DFF_85) { return measure_insertion_time<85>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(DFF_90) { return measure_insertion_time<90>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(DFF_95) { return measure_insertion_time<95>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(DFF_ADAPTIVE) { return measure_insertion_time<0>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(DFF_80_BITS) { return measure_bits_per_item<80>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(DFF_85_BITS) { return measure_bits_per_item<85>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(DFF_90_BITS) { return measure_bits_per_item<90>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(DFF_95_BITS) { return measure_bits_per_item<95>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(DFF_ADAPTIVE_BITS) { return measure_bits_per_item<0>(nums, n); }
+
+BENCHMARK_TASK_MAIN
@@ -0,0 +1,99 @@
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+
+#include <fmt/core.h>
+
+#include "../../src/DFF.hpp"
+#include "benchmark_utils.hpp"
+
+template <bool ENABLE_FINGERPRINT_GROWTH>
+void build(dff::DFF<uint64_t, ENABLE_FINGERPRINT_GROWTH> &filter, const uint64_t *nums,
+           const size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    if (filter.insert(nums[i]) != dff::Ok) {
+      const std::string msg =
+          fmt::format("Insertion failed: Unable to insert {} at index {}/{}", nums[i], i, n - 1);
+      throw std::runtime_error(msg);
+    }
+  }
+}
+
+template <bool ENABLE_FINGERPRINT_GROWTH>
+void check_no_false_negative(dff::DFF<uint64_t, ENABLE_FINGERPRINT_GROWTH> &filter,
+                             const uint64_t *nums, const size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    if (filter.query(nums[i]) != dff::Ok) {
+      const std::string msg =
+          fmt::format("Query failed (false negative): Unable to find element {} at index {}/{}",
+                      nums[i], i, n - 1);
+      throw std::runtime_error(msg);
+    }
+  }
+}
+
+// How a saved filter is read back
+enum class LoadMode : uint8_t { Load, Mmap, ImportTags };
+
+template <bool ENABLE_FINGERPRINT_GROWTH>
+auto measure_load_time(const uint64_t *nums, const size_t n, const LoadMode mode) -> double {
+  const auto path = (std::filesystem::temp_directory_path() /
+                     fmt::format("dff_load_time_{}_{}.bin", ENABLE_FINGERPRINT_GROWTH, n))
+                        .string();
+  {
+    dff::DFF<uint64_t, ENABLE_FINGERPRINT_GROWTH> filter(16);
+    build(filter, nums, n);
+    const dff::Status res =
+        mode == LoadMode::ImportTags ? filter.export_tags(path) : filter.save(path);
+    if (res != dff::Ok)
+      throw std::runtime_error(fmt::format("Save failed: Unable to write {}", path));
+  }
+
+  dff::DFF<uint64_t, ENABLE_FINGERPRINT_GROWTH> filter(16);
+  const double start = get_current_time_in_seconds();
+  const dff::Status res = mode == LoadMode::Mmap         ? filter.open_mmap(path)
+                          : mode == LoadMode::ImportTags ? filter.import_tags(path)
+                                                         : filter.load(path);
+  const double end = get_current_time_in_seconds();
+  if (res != dff::Ok)
+    throw std::runtime_error(fmt::format("Load failed: Unable to read {}", path));
+
+  check_no_false_negative(filter, nums, n);
+  std::filesystem::remove(path);
+  return end - start;
+}
+
+template <bool ENABLE_FINGERPRINT_GROWTH>
+auto measure_rebuild_time(const uint64_t *nums, const size_t n) -> double {
+  const double start = get_current_time_in_seconds();
+  dff::DFF<uint64_t, ENABLE_FINGERPRINT_GROWTH> filter(16);
+  build(filter, nums, n);
+  const double end = get_current_time_in_seconds();
+
+  check_no_false_negative(filter, nums, n);
+  return end - start;
+}
+
+REGISTER_BENCHMARK_TASK(DFF) { return measure_load_time<false>(nums, n, LoadMode::Load); }
+
+REGISTER_BENCHMARK_TASK(DFF_FG) { return measure_load_time<true>(nums, n, LoadMode::Load); }
+
+REGISTER_BENCHMARK_TASK(DFF_MMAP) { return measure_load_time<false>(nums, n, LoadMode::Mmap); }
+
+REGISTER_BENCHMARK_TASK(DFF_FG_MMAP) { return measure_load_time<true>(nums, n, LoadMode::Mmap); }
+
+REGISTER_BENCHMARK_TASK(DFF_IMPORT_TAGS) {
+  return measure_load_time<false>(nums, n, LoadMode::ImportTags);
+}
+
+REGISTER_BENCHMARK_TASK(DFF_FG_IMPORT_TAGS) {
+  return measure_load_time<true>(nums, n, LoadMode::ImportTags);
+}
+
+REGISTER_BENCHMARK_TASK(DFF_REBUILD) { return measure_rebuild_time<false>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(DFF_FG_REBUILD) { return measure_rebuild_time<true>(nums, n); }
+
+BENCHMARK_TASK_MAIN
@@ -0,0 +1,49 @@
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+
+#include <fmt/core.h>
+
+#include "../../src/DFF.hpp"
+#include "benchmark_utils.hpp"
+
+// Insert with an operation log synced every `SYNC_INTERVAL` operations, or without a log if 0
+template <size_t SYNC_INTERVAL>
+auto measure_insertion_time(const uint64_t *nums, const size_t n) -> double {
+  dff::DFF<uint64_t, false> filter(16);
+  const auto path =
+      (std::filesystem::temp_directory_path() / fmt::format("dff_log_{}.bin", SYNC_INTERVAL))
+          .string();
+  if (SYNC_INTERVAL != 0 && filter.open_log(path, SYNC_INTERVAL, true) != dff::Ok)
+    throw std::runtime_error(fmt::format("Unable to open the log {}", path));
+
+  // Test insertion, including the sync of the last group of operations
+  const double start = get_current_time_in_seconds();
+  for (size_t i = 0; i < n; i++) {
+    if (filter.insert(nums[i]) != dff::Ok) {
+      const std::string msg = fmt::format(
+          "Insertion failed: Unable to insert element {} at index {}/{}", nums[i], i, n - 1);
+      throw std::runtime_error(msg);
+    }
+  }
+  if (filter.close_log() != dff::Ok)
+    throw std::runtime_error(fmt::format("Unable to sync the log {}", path));
+  const double end = get_current_time_in_seconds();
+
+  std::filesystem::remove(path);
+  return end - start;
+}
+
+REGISTER_BENCHMARK_TASK(DFF) { return measure_insertion_time<0>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(DFF_LOG_16) { return measure_insertion_time<16>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(DFF_LOG_256) { return measure_insertion_time<256>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(DFF_LOG_4096) { return measure_insertion_time<4096>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(DFF_LOG_65536) { return measure_insertion_time<65536>(nums, n); }
+
+BENCHMARK_TASK_MAIN
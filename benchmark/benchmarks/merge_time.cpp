@@ -0,0 +1,56 @@
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include <fmt/core.h>
+
+#include "../../src/DFF.hpp"
+#include "benchmark_utils.hpp"
+
+// Combine a filter of the first half of the items with the second half, either by merging a
+// filter built from the second half, or by inserting the raw items of the second half
+template <bool ENABLE_FINGERPRINT_GROWTH, bool MERGE>
+auto measure_combination_time(const uint64_t *nums, const size_t n) -> double {
+  // Both filters need the same hash seed
+  constexpr uint64_t HASH_SEED = 1234;
+  dff::DFF<uint64_t, ENABLE_FINGERPRINT_GROWTH> filter(16, HASH_SEED);
+  dff::DFF<uint64_t, ENABLE_FINGERPRINT_GROWTH> other(16, HASH_SEED);
+
+  // Insert
+  for (size_t i = 0; i < n; i++) {
+    if ((i < n / 2 ? filter : other).insert(nums[i]) != dff::Ok) {
+      const std::string msg = fmt::format(
+          "Insertion failed: Unable to insert element {} at index {}/{}", nums[i], i, n - 1);
+      throw std::runtime_error(msg);
+    }
+  }
+
+  // Test combination
+  const double start = get_current_time_in_seconds();
+  if constexpr (MERGE) {
+    if (filter.merge_from(other) != dff::Ok)
+      throw std::runtime_error("Merge failed");
+  } else {
+    for (size_t i = n / 2; i < n; i++) {
+      if (filter.insert(nums[i]) != dff::Ok) {
+        const std::string msg = fmt::format(
+            "Insertion failed: Unable to insert element {} at index {}/{}", nums[i], i, n - 1);
+        throw std::runtime_error(msg);
+      }
+    }
+  }
+  const double end = get_current_time_in_seconds();
+
+  return end - start;
+}
+
+REGISTER_BENCHMARK_TASK(DFF_MERGE) { return measure_combination_time<false, true>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(DFF_REINSERT) { return measure_combination_time<false, false>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(DFF_FG_MERGE) { return measure_combination_time<true, true>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(DFF_FG_REINSERT) { return measure_combination_time<true, false>(nums, n); }
+
+BENCHMARK_TASK_MAIN
@@ -15,7 +15,7 @@
 #include "benchmark_utils.hpp"
 
 REGISTER_BENCHMARK_TASK(DFF) {
-  dff::DFF<uint64_t, false, false, true> filter(16);
+  dff::DFF<uint64_t, false, dff::DefaultConfig, false, true> filter(16);
 
   // Insert
   for (size_t i = 0; i < n; i++) {
@@ -53,7 +53,7 @@ REGISTER_BENCHMARK_TASK(DFF) {
 }
 
 REGISTER_BENCHMARK_TASK(DFF_FG) {
-  dff::DFF<uint64_t, true, false, true> filter(16);
+  dff::DFF<uint64_t, true, dff::DefaultConfig, false, true> filter(16);
 
   // Insert
   for (size_t i = 0; i < n; i++) {
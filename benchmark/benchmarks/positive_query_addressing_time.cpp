@@ -16,7 +16,7 @@
 #include "benchmark_utils.hpp"
 
 REGISTER_BENCHMARK_TASK(DFF) {
-  auto *filter = new dff::DFF<uint64_t, false, false, true>(16);
+  auto *filter = new dff::DFF<uint64_t, false, dff::DefaultConfig, false, true>(16);
 
   // Insert
   for (size_t i = 0; i < n; i++) {
@@ -41,7 +41,7 @@ REGISTER_BENCHMARK_TASK(DFF) {
 }
 
 REGISTER_BENCHMARK_TASK(DFF_FG) {
-  auto *filter = new dff::DFF<uint64_t, true, false, true>(16);
+  auto *filter = new dff::DFF<uint64_t, true, dff::DefaultConfig, false, true>(16);
 
   // Insert
   for (size_t i = 0; i < n; i++) {
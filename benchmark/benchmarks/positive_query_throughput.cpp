@@ -68,6 +68,114 @@ REGISTER_BENCHMARK_TASK(DFF_FG) {
   return end - start;
 }
 
+REGISTER_BENCHMARK_TASK(DFF8) {
+  dff::DFF8<uint64_t> filter(8);
+
+  // Insert
+  for (size_t i = 0; i < n; i++) {
+    if (filter.insert(nums[i]) != dff::Ok) {
+      const std::string msg = fmt::format(
+          "Insertion failed: Unable to insert element {} at index {}/{}", nums[i], i, n - 1);
+      throw std::runtime_error(msg);
+    }
+  }
+
+  // Test positive query
+  const double start = get_current_time_in_seconds();
+  for (size_t i = 0; i < n; i++) {
+    if (filter.query(nums[i]) != dff::Ok) {
+      const std::string msg =
+          fmt::format("Query failed (false negative): Unable to find element {} at index {}/{}",
+                      nums[i], i, n - 1);
+      throw std::runtime_error(msg);
+    }
+  }
+  const double end = get_current_time_in_seconds();
+
+  return end - start;
+}
+
+REGISTER_BENCHMARK_TASK(DFF12) {
+  dff::DFF12<uint64_t> filter(12);
+
+  // Insert
+  for (size_t i = 0; i < n; i++) {
+    if (filter.insert(nums[i]) != dff::Ok) {
+      const std::string msg = fmt::format(
+          "Insertion failed: Unable to insert element {} at index {}/{}", nums[i], i, n - 1);
+      throw std::runtime_error(msg);
+    }
+  }
+
+  // Test positive query
+  const double start = get_current_time_in_seconds();
+  for (size_t i = 0; i < n; i++) {
+    if (filter.query(nums[i]) != dff::Ok) {
+      const std::string msg =
+          fmt::format("Query failed (false negative): Unable to find element {} at index {}/{}",
+                      nums[i], i, n - 1);
+      throw std::runtime_error(msg);
+    }
+  }
+  const double end = get_current_time_in_seconds();
+
+  return end - start;
+}
+
+REGISTER_BENCHMARK_TASK(DFF16) {
+  dff::DFF16<uint64_t> filter(16);
+
+  // Insert
+  for (size_t i = 0; i < n; i++) {
+    if (filter.insert(nums[i]) != dff::Ok) {
+      const std::string msg = fmt::format(
+          "Insertion failed: Unable to insert element {} at index {}/{}", nums[i], i, n - 1);
+      throw std::runtime_error(msg);
+    }
+  }
+
+  // Test positive query
+  const double start = get_current_time_in_seconds();
+  for (size_t i = 0; i < n; i++) {
+    if (filter.query(nums[i]) != dff::Ok) {
+      const std::string msg =
+          fmt::format("Query failed (false negative): Unable to find element {} at index {}/{}",
+                      nums[i], i, n - 1);
+      throw std::runtime_error(msg);
+    }
+  }
+  const double end = get_current_time_in_seconds();
+
+  return end - start;
+}
+
+REGISTER_BENCHMARK_TASK(DFF_SS) {
+  dff::SemiSortedDFF<uint64_t> filter(16);
+
+  // Insert
+  for (size_t i = 0; i < n; i++) {
+    if (filter.insert(nums[i]) != dff::Ok) {
+      const std::string msg = fmt::format(
+          "Insertion failed: Unable to insert element {} at index {}/{}", nums[i], i, n - 1);
+      throw std::runtime_error(msg);
+    }
+  }
+
+  // Test positive query
+  const double start = get_current_time_in_seconds();
+  for (size_t i = 0; i < n; i++) {
+    if (filter.query(nums[i]) != dff::Ok) {
+      const std::string msg =
+          fmt::format("Query failed (false negative): Unable to find element {} at index {}/{}",
+                      nums[i], i, n - 1);
+      throw std::runtime_error(msg);
+    }
+  }
+  const double end = get_current_time_in_seconds();
+
+  return end - start;
+}
+
 REGISTER_BENCHMARK_TASK(IFF) {
   infinifilter::ChainedInfiniFilter filter(6, 16 + /* flag bits */ 3);
 
@@ -0,0 +1,84 @@
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include <fmt/core.h>
+
+#include "../../src/DFF.hpp"
+#include "benchmark_utils.hpp"
+
+// Queries checking both buckets slot by slot, the primary bucket first, or both buckets without
+// branching
+template <dff::QueryStrategy STRATEGY>
+using Filter = dff::DFF<uint64_t, false, dff::QueryConfig<STRATEGY>>;
+
+template <dff::QueryStrategy STRATEGY>
+void insert_all(Filter<STRATEGY> &filter, const uint64_t *nums, const size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    if (filter.insert(nums[i]) != dff::Ok) {
+      const std::string msg = fmt::format(
+          "Insertion failed: Unable to insert element {} at index {}/{}", nums[i], i, n - 1);
+      throw std::runtime_error(msg);
+    }
+  }
+}
+
+// Positive query time
+template <dff::QueryStrategy STRATEGY>
+auto measure_positive_query_time(const uint64_t *nums, const size_t n) -> double {
+  Filter<STRATEGY> filter(16);
+  insert_all(filter, nums, n);
+  const double start = get_current_time_in_seconds();
+  for (size_t i = 0; i < n; i++) {
+    if (filter.query(nums[i]) != dff::Ok) {
+      const std::string msg =
+          fmt::format("Query failed (false negative): Unable to find element {} at index {}/{}",
+                      nums[i], i, n - 1);
+      throw std::runtime_error(msg);
+    }
+  }
+  return get_current_time_in_seconds() - start;
+}
+
+// Negative query time
+template <dff::QueryStrategy STRATEGY>
+auto measure_negative_query_time(const uint64_t *nums, const size_t n) -> double {
+  Filter<STRATEGY> filter(16);
+  insert_all(filter, nums, n);
+  size_t false_positive_count = 0;
+  const double start = get_current_time_in_seconds();
+  for (size_t i = 0; i < n; i++)
+    if (filter.query(nums[n + i]) == dff::Ok)
+      false_positive_count++;
+  const double end = get_current_time_in_seconds();
+  if (false_positive_count == 0)
+    throw std::runtime_error("Query failed: should have some false positives, but none found");
+  return end - start;
+}
+
+REGISTER_BENCHMARK_TASK(DFF) {
+  return measure_positive_query_time<dff::QueryStrategy::Interleaved>(nums, n);
+}
+
+REGISTER_BENCHMARK_TASK(DFF_PRIMARY) {
+  return measure_positive_query_time<dff::QueryStrategy::PrimaryFirst>(nums, n);
+}
+
+REGISTER_BENCHMARK_TASK(DFF_BRANCHLESS) {
+  return measure_positive_query_time<dff::QueryStrategy::Branchless>(nums, n);
+}
+
+REGISTER_BENCHMARK_TASK(DFF_NEG) {
+  return measure_negative_query_time<dff::QueryStrategy::Interleaved>(nums, n);
+}
+
+REGISTER_BENCHMARK_TASK(DFF_PRIMARY_NEG) {
+  return measure_negative_query_time<dff::QueryStrategy::PrimaryFirst>(nums, n);
+}
+
+REGISTER_BENCHMARK_TASK(DFF_BRANCHLESS_NEG) {
+  return measure_negative_query_time<dff::QueryStrategy::Branchless>(nums, n);
+}
+
+BENCHMARK_TASK_MAIN
@@ -0,0 +1,144 @@
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+#include <fmt/core.h>
+
+#include "../../src/DFF.hpp"
+#include "../impl/bamboofilter/bamboofilter.hpp"
+#include "benchmark_utils.hpp"
+
+// Number of deletion/reinsertion waves
+constexpr size_t ROUNDS = 3;
+// Fraction of the inserted elements kept by each deletion wave
+constexpr size_t KEEP_DIVISOR = 10;
+
+REGISTER_BENCHMARK_TASK(DFF) {
+  dff::DFF<uint64_t, false> filter(16);
+  filter.set_shrink_autonomously(true);
+
+  const double start = get_current_time_in_seconds();
+  for (size_t i = 0; i < n; i++) {
+    if (filter.insert(nums[i]) != dff::Ok) {
+      const std::string msg =
+          fmt::format("Insertion failed: Unable to insert {} at index {}/{}", nums[i], i, n - 1);
+      throw std::runtime_error(msg);
+    }
+  }
+  for (size_t round = 0; round < ROUNDS; round++) {
+    for (size_t i = n / KEEP_DIVISOR; i < n; i++) {
+      if (filter.remove(nums[i]) != dff::Ok) {
+        const std::string msg =
+            fmt::format("Deletion failed: Unable to delete {} at index {}/{}", nums[i], i, n - 1);
+        throw std::runtime_error(msg);
+      }
+    }
+    for (size_t i = n / KEEP_DIVISOR; i < n; i++) {
+      if (filter.insert(nums[i]) != dff::Ok) {
+        const std::string msg =
+            fmt::format("Insertion failed: Unable to insert {} at index {}/{}", nums[i], i, n - 1);
+        throw std::runtime_error(msg);
+      }
+    }
+  }
+  const double end = get_current_time_in_seconds();
+
+  // Make sure no false negative happens
+  for (size_t i = 0; i < n; i++) {
+    if (filter.query(nums[i]) != dff::Ok) {
+      const std::string msg =
+          fmt::format("Query failed (false negative): Unable to find element {} at index {}/{}",
+                      nums[i], i, n - 1);
+      throw std::runtime_error(msg);
+    }
+  }
+
+  return end - start;
+}
+
+REGISTER_BENCHMARK_TASK(DFF_FG) {
+  dff::DFF<uint64_t, true> filter(16);
+  filter.set_shrink_autonomously(true);
+
+  const double start = get_current_time_in_seconds();
+  for (size_t i = 0; i < n; i++) {
+    if (filter.insert(nums[i]) != dff::Ok) {
+      const std::string msg =
+          fmt::format("Insertion failed: Unable to insert {} at index {}/{}", nums[i], i, n - 1);
+      throw std::runtime_error(msg);
+    }
+  }
+  for (size_t round = 0; round < ROUNDS; round++) {
+    for (size_t i = n / KEEP_DIVISOR; i < n; i++) {
+      if (filter.remove(nums[i]) != dff::Ok) {
+        const std::string msg =
+            fmt::format("Deletion failed: Unable to delete {} at index {}/{}", nums[i], i, n - 1);
+        throw std::runtime_error(msg);
+      }
+    }
+    for (size_t i = n / KEEP_DIVISOR; i < n; i++) {
+      if (filter.insert(nums[i]) != dff::Ok) {
+        const std::string msg =
+            fmt::format("Insertion failed: Unable to insert {} at index {}/{}", nums[i], i, n - 1);
+        throw std::runtime_error(msg);
+      }
+    }
+  }
+  const double end = get_current_time_in_seconds();
+
+  // Make sure no false negative happens
+  for (size_t i = 0; i < n; i++) {
+    if (filter.query(nums[i]) != dff::Ok) {
+      const std::string msg =
+          fmt::format("Query failed (false negative): Unable to find element {} at index {}/{}",
+                      nums[i], i, n - 1);
+      throw std::runtime_error(msg);
+    }
+  }
+
+  return end - start;
+}
+
+REGISTER_BENCHMARK_TASK(BBF) {
+  bamboofilter::BambooFilter<uint64_t> filter(initial_capacity, 4, /* enable_compress */ true);
+
+  const double start = get_current_time_in_seconds();
+  for (size_t i = 0; i < n; i++) {
+    if (!filter.Insert(nums[i])) {
+      const std::string msg =
+          fmt::format("Insertion failed: Unable to insert {} at index {}/{}", nums[i], i, n - 1);
+      throw std::runtime_error(msg);
+    }
+  }
+  for (size_t round = 0; round < ROUNDS; round++) {
+    for (size_t i = n / KEEP_DIVISOR; i < n; i++) {
+      if (!filter.Delete(nums[i])) {
+        const std::string msg =
+            fmt::format("Deletion failed: Unable to delete {} at index {}/{}", nums[i], i, n - 1);
+        throw std::runtime_error(msg);
+      }
+    }
+    for (size_t i = n / KEEP_DIVISOR; i < n; i++) {
+      if (!filter.Insert(nums[i])) {
+        const std::string msg =
+            fmt::format("Insertion failed: Unable to insert {} at index {}/{}", nums[i], i, n - 1);
+        throw std::runtime_error(msg);
+      }
+    }
+  }
+  const double end = get_current_time_in_seconds();
+
+  // Make sure no false negative happens
+  for (size_t i = 0; i < n; i++) {
+    if (!filter.Lookup(nums[i])) {
+      const std::string msg =
+          fmt::format("Query failed (false negative): Unable to find element {} at index {}/{}",
+                      nums[i], i, n - 1);
+      throw std::runtime_error(msg);
+    }
+  }
+
+  return end - start;
+}
+
+BENCHMARK_TASK_MAIN
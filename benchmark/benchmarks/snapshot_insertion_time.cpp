@@ -0,0 +1,43 @@
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+
+#include <fmt/core.h>
+
+#include "../../src/DFF.hpp"
+#include "benchmark_utils.hpp"
+
+// Insert the second half of the items, holding a snapshot of the first half if `HOLD_SNAPSHOT`
+template <bool ENABLE_FINGERPRINT_GROWTH, bool HOLD_SNAPSHOT>
+auto measure_insertion_time(const uint64_t *nums, const size_t n) -> double {
+  dff::DFF<uint64_t, ENABLE_FINGERPRINT_GROWTH> filter(16);
+  for (size_t i = 0; i < n / 2; i++)
+    if (filter.insert(nums[i]) != dff::Ok)
+      throw std::runtime_error(fmt::format("Insertion failed: Unable to insert {}", nums[i]));
+  std::optional<typename dff::DFF<uint64_t, ENABLE_FINGERPRINT_GROWTH>::Snapshot> snapshot;
+  if constexpr (HOLD_SNAPSHOT)
+    snapshot.emplace(filter.snapshot());
+
+  const double start = get_current_time_in_seconds();
+  for (size_t i = n / 2; i < n; i++) {
+    if (filter.insert(nums[i]) != dff::Ok) {
+      const std::string msg = fmt::format(
+          "Insertion failed: Unable to insert element {} at index {}/{}", nums[i], i, n - 1);
+      throw std::runtime_error(msg);
+    }
+  }
+  const double end = get_current_time_in_seconds();
+
+  return end - start;
+}
+
+REGISTER_BENCHMARK_TASK(DFF) { return measure_insertion_time<false, false>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(DFF_FG) { return measure_insertion_time<true, false>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(DFF_SNAPSHOT) { return measure_insertion_time<false, true>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(DFF_FG_SNAPSHOT) { return measure_insertion_time<true, true>(nums, n); }
+
+BENCHMARK_TASK_MAIN
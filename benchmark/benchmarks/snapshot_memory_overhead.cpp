@@ -0,0 +1,40 @@
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+#include <fmt/core.h>
+
+#include "../../src/DFF.hpp"
+#include "benchmark_utils.hpp"
+
+// Memory held only by a snapshot of `n - WRITES` items after `WRITES` more insertions, relative to
+// the memory used by the filter
+template <size_t WRITES>
+auto measure_memory_overhead(const uint64_t *nums, const size_t n) -> double {
+  if (WRITES > n)
+    throw std::runtime_error(fmt::format("Too few items for {} writes", WRITES));
+
+  dff::DFF<uint64_t, false> filter(16);
+  for (size_t i = 0; i < n - WRITES; i++)
+    if (filter.insert(nums[i]) != dff::Ok)
+      throw std::runtime_error(fmt::format("Insertion failed: Unable to insert {}", nums[i]));
+  const auto snapshot = filter.snapshot();
+  for (size_t i = n - WRITES; i < n; i++)
+    if (filter.insert(nums[i]) != dff::Ok)
+      throw std::runtime_error(fmt::format("Insertion failed: Unable to insert {}", nums[i]));
+
+  return static_cast<double>(snapshot.exclusive_memory_usage()) /
+         static_cast<double>(filter.memory_usage());
+}
+
+REGISTER_BENCHMARK_TASK(WRITES_10) { return measure_memory_overhead<10>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(WRITES_100) { return measure_memory_overhead<100>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(WRITES_1000) { return measure_memory_overhead<1'000>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(WRITES_10000) { return measure_memory_overhead<10'000>(nums, n); }
+
+REGISTER_BENCHMARK_TASK(WRITES_100000) { return measure_memory_overhead<100'000>(nums, n); }
+
+BENCHMARK_TASK_MAIN
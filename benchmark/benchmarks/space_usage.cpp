@@ -1,7 +1,6 @@
 #include <cstddef>
 #include <cstdint>
 #include <stdexcept>
-#include <unordered_set>
 
 #include <fmt/core.h>
 
@@ -28,15 +27,8 @@ REGISTER_BENCHMARK_TASK(DFF) {
   }
 
   size_t bits_used = 0UZ;
-  std::unordered_set<const dff::Segment<uint64_t, false> *> visited_segs;
-  for (const dff::Segment<uint64_t, false> *seg : filter.lookup_table) {
-    if (seg == nullptr)
-      continue;
-    if (visited_segs.contains(seg))
-      continue;
-    visited_segs.insert(seg);
+  for (const auto *seg = filter.head; seg != nullptr; seg = seg->next)
     bits_used += dff::BUCKETS_PER_SEG * dff::SLOTS_PER_BUCKET * (seg->k_bits_per_item);
-  }
   return static_cast<double>(bits_used);
 }
 
@@ -52,15 +44,26 @@ REGISTER_BENCHMARK_TASK(DFF_FG) {
   }
 
   size_t bits_used = 0UZ;
-  std::unordered_set<const dff::Segment<uint64_t, true> *> visited_segs;
-  for (const dff::Segment<uint64_t, true> *seg : filter.lookup_table) {
-    if (seg == nullptr)
-      continue;
-    if (visited_segs.contains(seg))
-      continue;
-    visited_segs.insert(seg);
+  for (const auto *seg = filter.head; seg != nullptr; seg = seg->next)
     bits_used += dff::BUCKETS_PER_SEG * dff::SLOTS_PER_BUCKET * (seg->k_bits_per_item + 1);
+  return static_cast<double>(bits_used);
+}
+
+REGISTER_BENCHMARK_TASK(DFF_SS) {
+  dff::SemiSortedDFF<uint64_t> filter(16);
+
+  for (size_t i = 0; i < n; i++) {
+    if (filter.insert(nums[i]) != dff::Ok) {
+      const std::string msg =
+          fmt::format("Insertion failed: Unable to insert {} at index {}/{}", nums[i], i, n - 1);
+      throw std::runtime_error(msg);
+    }
   }
+
+  // Semi-sorted buckets take 4 bits less than 4 tags (plus padding)
+  size_t bits_used = 0UZ;
+  for (const auto *seg = filter.head; seg != nullptr; seg = seg->next)
+    bits_used += seg->table->size_in_bytes() * 8;
   return static_cast<double>(bits_used);
 }
 
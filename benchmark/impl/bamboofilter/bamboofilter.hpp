@@ -49,6 +49,10 @@ private:
   uint32_t next_split_idx_;
   uint32_t num_items_;
 
+  /* Modified start: Make compress optional, only enabled for shrink benchmarks */
+  bool enable_compress_ = false;
+  /* Modified end: Make compress optional, only enabled for shrink benchmarks */
+
   [[nodiscard]] inline auto BucketIndexHash(uint32_t hash) const -> uint32_t {
     return hash & ((1 << BUCKETS_PER_SEG_POWER) - 1);
   }
@@ -91,11 +95,17 @@ public:
   auto operator=(const BambooFilter &) -> BambooFilter & = default;
   auto operator=(BambooFilter &&) -> BambooFilter & = default;
 
-  BambooFilter(uint32_t capacity, uint32_t split_condition_param)
+  /* Modified start: Make compress optional, only enabled for shrink benchmarks */
+  BambooFilter(uint32_t capacity, uint32_t split_condition_param, bool enable_compress = false)
+      /* Modified end: Make compress optional, only enabled for shrink benchmarks */
       : k_init_table_bits(
             static_cast<uint32_t>(std::ceil(std::log2(static_cast<double>(capacity) / 4)))),
         num_table_bits_(k_init_table_bits),
         num_seg_bits_(k_init_table_bits - BUCKETS_PER_SEG_POWER) {
+    /* Modified start: Make compress optional, only enabled for shrink benchmarks */
+    enable_compress_ = enable_compress;
+    /* Modified end: Make compress optional, only enabled for shrink benchmarks */
+
     for (int num_segment = 0; num_segment < (1 << num_seg_bits_); num_segment++) {
       hash_table_.push_back(new Segment(1 << BUCKETS_PER_SEG_POWER));
     }
@@ -146,11 +156,12 @@ public:
 
     if (hash_table_[seg_index]->Delete(bucket_index, tag)) {
       num_items_--;
-      /* Modified start: Disable compress for benchmark, since we do not implement it in DFF */
-      // if (!(num_items_ & split_condition_)) {
-      //   Compress();
-      // }
-      /* Modified end: Disable compress for benchmark, since we do not implement it in DFF */
+      /* Modified start: Make compress optional, only enabled for shrink benchmarks */
+      if (enable_compress_ && !(num_items_ & split_condition_) &&
+          hash_table_.size() > (1UZ << (k_init_table_bits - BUCKETS_PER_SEG_POWER))) {
+        Compress();
+      }
+      /* Modified end: Make compress optional, only enabled for shrink benchmarks */
       return true;
     }
 
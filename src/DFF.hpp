@@ -1,18 +1,41 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
+#include <bit>
 #include <chrono>
+#include <cerrno>
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <istream>
 #include <numbers>
+#include <ostream>
 #include <random>
+#include <string>
+#include <system_error>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #include "predefine.hpp"
 #include "segment.hpp"
+#include "utils/arena.hpp"
 #include "utils/bits.hpp"
 #include "utils/hash.hpp"
+#include "utils/io.hpp"
+#include "utils/mapped_file_arena.hpp"
 
 namespace dff {
 
@@ -22,13 +45,121 @@ inline auto get_current_time_in_seconds() -> double {
   return std::chrono::duration_cast<std::chrono::duration<double>>(duration).count();
 }
 
-template <typename T, bool ENABLE_FINGERPRINT_GROWTH = false,
+template <typename T, bool ENABLE_FINGERPRINT_GROWTH, typename Config> class SharedDFF;
+
+template <typename T, bool ENABLE_FINGERPRINT_GROWTH = false, typename Config = DefaultConfig,
           bool BENCHMARK_TRACK_EXPANSION_TIME = false, bool BENCHMARK_TRACK_ADDRESSING_TIME = false>
 class DFF {
+public:
+  class Snapshot;
+
+private:
+  friend class SharedDFF<T, ENABLE_FINGERPRINT_GROWTH, Config>;
+
+  // The geometry, see `Config`
+  static constexpr size_t LOOKUP_TABLE_SIZE = Config::LOOKUP_TABLE_SIZE;
+  static constexpr size_t BUCKETS_PER_SEG = Config::BUCKETS_PER_SEG;
+  static constexpr size_t SLOTS_PER_BUCKET = Config::SLOTS_PER_BUCKET;
+  static constexpr size_t INITIAL_SEG_COUNT = Config::INITIAL_SEG_COUNT;
+  static constexpr size_t INITIAL_LOOKUP_TABLE_ENTRIES_PER_SEG =
+      Config::INITIAL_LOOKUP_TABLE_ENTRIES_PER_SEG;
+  static constexpr size_t TABLE_MASK = Config::TABLE_MASK;
+
   static constexpr uint32_t LOWER_32_BIT_MASK = LOWER_BITS_MASK_64(32);
+  // Merge two sibling segments on `compact` only if the merged segment would be at most half full,
+  // so that it can take new items for a while before being expanded again
+  static constexpr double DEFAULT_COMPACT_LOAD_FACTOR = 0.5;
+  // Low-water mark of automatic shrinking on `remove`, see `set_shrink_autonomously`
+  static constexpr double DEFAULT_SHRINK_LOW_WATER_MARK = 0.4;
+  // Range of load thresholds accepted by `set_load_threshold`. Beyond the maximum, insertions
+  // start failing to find cuckoo paths
+  static constexpr double MIN_LOAD_THRESHOLD = 0.5;
+  static constexpr double MAX_LOAD_THRESHOLD = 0.95;
+  // Kick rate beyond which a segment is expanded by default, see `set_adaptive_expansion`
+  static constexpr double DEFAULT_MAX_KICK_RATE = 1.0;
+  // Weight of an insertion in `Segment::kick_rate`, which thus averages about the last 64
+  static constexpr double KICK_RATE_WEIGHT = 1.0 / 64;
+  // Standard deviations of the number of items per segment that `reserve` leaves room for, so
+  // that even with the most segments, the fullest one very rarely exceeds its capacity
+  static constexpr double RESERVE_LOAD_STD_DEVS = 5.0;
+  // Identifies a filter written by `save` ("DFFILTER" in little-endian byte order)
+  static constexpr uint64_t FILE_MAGIC = 0x5245544C49464644;
+  // Version of the format written by `save`, bumped on incompatible changes
+  static constexpr uint64_t FILE_VERSION = 4;
+  // Identifies a manifest written by `checkpoint` ("DFFCKPT" in little-endian byte order)
+  static constexpr uint64_t CHECKPOINT_MAGIC = 0x0054504B43464644;
+  // Identifies a log written by `open_log` ("DFFWAL" in little-endian byte order)
+  static constexpr uint64_t LOG_MAGIC = 0x00004C4157464644;
+  // Identifies a tag stream written by `export_tags` ("DFFTAGS" in little-endian byte order)
+  static constexpr uint64_t TAGS_MAGIC = 0x0053474154464644;
+
+  // Operations recorded by the log, see `open_log`
+  enum class LogOp : uint8_t { Insert = 1, Remove = 2 };
+  // A log entry is the 64-bit hash of the item followed by the operation
+  static constexpr size_t LOG_ENTRY_SIZE = sizeof(uint64_t) + sizeof(LogOp);
+  // Number of log entries partitioned by segment at a time by `replay_log`
+  static constexpr size_t LOG_REPLAY_BATCH_SIZE = 1UZ << 16;
 
   size_t k_initial_bits_per_item;
-  uint64_t k_hash_seed = generate_hash_seed();
+  // Saved with the filter, see `hash_seed`
+  uint64_t k_hash_seed = 0;
+
+  // Whether to merge sibling segments automatically on `remove`
+  bool shrink_autonomously_ = false;
+  double shrink_low_water_mark_ = DEFAULT_SHRINK_LOW_WATER_MARK;
+
+  // Fraction of the slots of a segment filled before it is expanded, see `set_load_threshold`
+  double load_threshold_ = DEFAULT_LOAD_THRESHOLD;
+  // Kick rate beyond which a segment is expanded, 0 if adaptive expansion is disabled
+  double max_kick_rate_ = 0.0;
+
+  // Maximum memory usage in bytes, 0 if unlimited
+  size_t memory_budget_ = 0;
+  // Memory used by the filter and its segments in bytes
+  size_t memory_usage_ =
+      sizeof(DFF) + (sizeof(Segment<T, ENABLE_FINGERPRINT_GROWTH, Config> *) + sizeof(size_t)) *
+                        LOOKUP_TABLE_SIZE;
+
+  // File mapping whose bytes are borrowed by segment tables, see `open_mmap`
+  uint8_t *mapped_addr_ = nullptr;
+  size_t mapped_length_ = 0;
+
+  // Directory and number of the last checkpoint, see `checkpoint`
+  std::string checkpoint_dir_;
+  uint64_t checkpoint_epoch_ = 0;
+
+  // Where the tag storage of new segments is allocated from if not `nullptr`, see the constructor
+  Arena *table_arena_ = nullptr;
+
+  // Operation log appended to by `insert` and `remove`, see `open_log`
+  int log_fd_ = -1;
+  size_t log_sync_interval_ = 1;
+  // Entries not written to the log yet
+  std::vector<uint8_t> log_buffer_;
+
+  /**
+   * @brief Calculate the memory used by a segment.
+   *
+   * @param bits_per_item Bits per item of the segment.
+   * @return The memory usage in bytes.
+   */
+  [[nodiscard]] static constexpr auto segment_memory_usage(const size_t bits_per_item) -> size_t {
+    return sizeof(Segment<T, ENABLE_FINGERPRINT_GROWTH, Config>) +
+           sizeof(SingleTable<ENABLE_FINGERPRINT_GROWTH, Config>) +
+           SingleTable<ENABLE_FINGERPRINT_GROWTH, Config>::size_in_bytes(BUCKETS_PER_SEG,
+                                                                         bits_per_item);
+  }
+
+  /**
+   * @brief Calculate the bits per item of the segment split from a segment by `expand`.
+   *
+   * @param seg The segment to be expanded.
+   * @return The bits per item of the new segment.
+   */
+  [[nodiscard]] auto
+  expanded_bits_per_item(const Segment<T, ENABLE_FINGERPRINT_GROWTH, Config> *seg) const -> size_t {
+    return ENABLE_FINGERPRINT_GROWTH ? seg->k_bits_per_item + 1 : k_initial_bits_per_item;
+  }
 
   /**
    * @brief Generate a random seed for hash functions.
@@ -61,6 +192,20 @@ class DFF {
    * @return The calculated index.
    */
   [[nodiscard]] auto segment_index(const uint32_t hash) const -> size_t {
+    return segment_index(hash, max_expansion, k_l_log);
+  }
+
+  /**
+   * @brief Same as `segment_index(uint32_t)`, but with the expansion state of a filter given
+   * explicitly, e.g., read from shared memory (see `SharedDFF`).
+   *
+   * @param hash The hash (the full hash, not the tag) to calculate the index for.
+   * @param max_expansion See `DFF::max_expansion`.
+   * @param l_log See `DFF::k_l_log`.
+   * @return The calculated index.
+   */
+  [[nodiscard]] static auto segment_index(const uint32_t hash, const size_t *max_expansion,
+                                          const size_t l_log) -> size_t {
     // size_t generateTableIndex_Tag(const size_t& index, const uint32_t& tag) {
     //   size_t index_e = max_expansion[index / l];
     //   size_t res =
@@ -72,7 +217,7 @@ class DFF {
     const size_t initial_index = hash & TABLE_MASK;
     // Correct the index if expansion happens
     const size_t index_e = max_expansion[initial_index / INITIAL_LOOKUP_TABLE_ENTRIES_PER_SEG];
-    const size_t res = ((initial_index >> k_l_log) << k_l_log) +
+    const size_t res = ((initial_index >> l_log) << l_log) +
                        (static_cast<uint64_t>(hash) >> (32 - index_e)) *
                            (INITIAL_LOOKUP_TABLE_ENTRIES_PER_SEG >> index_e);
     return res;
@@ -84,7 +229,7 @@ class DFF {
    * @param hash The hash to generate the index for.
    * @return The index.
    */
-  [[nodiscard]] auto bucket_index_hash(const uint32_t hash) const -> size_t {
+  [[nodiscard]] static auto bucket_index_hash(const uint32_t hash) -> size_t {
     // NOTE: Assume that BUCKETS_PER_SEG is a power of 2
     return hash & (BUCKETS_PER_SEG - 1);
   }
@@ -98,18 +243,30 @@ class DFF {
    */
   constexpr void generate_bucket_index_and_hash(const T &item, uint32_t *bucket_idx,
                                                 uint32_t *hash) const {
-    const uint64_t full_hash = DFF::hash(item, k_hash_seed);
+    split_hash(DFF::hash(item, k_hash_seed), bucket_idx, hash);
+  }
 
+  /**
+   * @brief Split the full hash of an item into its bucket index and hash.
+   *
+   * @param full_hash The full hash of the item.
+   * @param bucket_idx The bucket index.
+   * @param hash The hash.
+   */
+  static constexpr void split_hash(const uint64_t full_hash, uint32_t *bucket_idx,
+                                   uint32_t *hash) {
     *bucket_idx = bucket_index_hash(full_hash >> 32);
     *hash = full_hash & LOWER_32_BIT_MASK;
   }
 
 public:
-  Segment<T, ENABLE_FINGERPRINT_GROWTH> *head = nullptr;
-  Segment<T, ENABLE_FINGERPRINT_GROWTH> *tail = nullptr;
+  Segment<T, ENABLE_FINGERPRINT_GROWTH, Config> *head = nullptr;
+  Segment<T, ENABLE_FINGERPRINT_GROWTH, Config> *tail = nullptr;
 
-  Segment<T, ENABLE_FINGERPRINT_GROWTH> *lookup_table[LOOKUP_TABLE_SIZE];
-  size_t expansion_times[LOOKUP_TABLE_SIZE] = {0};
+  // Heap-allocated, so that moving a filter does not copy them
+  Segment<T, ENABLE_FINGERPRINT_GROWTH, Config> **lookup_table =
+      new Segment<T, ENABLE_FINGERPRINT_GROWTH, Config> *[LOOKUP_TABLE_SIZE];
+  size_t *expansion_times = new size_t[LOOKUP_TABLE_SIZE]();
   size_t max_expansion[INITIAL_SEG_COUNT] = {0};
   size_t k_l_log =
       static_cast<size_t>(std::log(INITIAL_LOOKUP_TABLE_ENTRIES_PER_SEG) / std::numbers::ln2);
@@ -123,35 +280,115 @@ public:
   // Only calculated when `BENCHMARK_TRACK_ADDRESSING_TIME` is true
   double total_addressing_time = 0.0;
 
-  DFF(const DFF &) = default;
-  DFF(DFF &&) = default;
-  auto operator=(const DFF &) -> DFF & = default;
-  auto operator=(DFF &&) -> DFF & = default;
+  // Deep copy, see `clone`. The copy has no checkpoint, so that its first one is a full one instead
+  // of extending the checkpoints of `other`
+  DFF(const DFF &other)
+      : k_initial_bits_per_item(other.k_initial_bits_per_item), k_hash_seed(other.k_hash_seed),
+        shrink_autonomously_(other.shrink_autonomously_),
+        shrink_low_water_mark_(other.shrink_low_water_mark_),
+        load_threshold_(other.load_threshold_), max_kick_rate_(other.max_kick_rate_),
+        memory_budget_(other.memory_budget_), memory_usage_(other.memory_usage_),
+        k_l_log(other.k_l_log), num_seg(other.num_seg),
+        total_expansion_time(other.total_expansion_time),
+        total_addressing_time(other.total_addressing_time) {
+    memcpy(expansion_times, other.expansion_times, sizeof(size_t) * LOOKUP_TABLE_SIZE);
+    std::copy(std::begin(other.max_expansion), std::end(other.max_expansion), max_expansion);
+    for (const auto *seg = other.head; seg != nullptr; seg = seg->next) {
+      auto *copy = new Segment<T, ENABLE_FINGERPRINT_GROWTH, Config>(*seg);
+      if (head == nullptr)
+        head = copy;
+      else
+        tail->next = copy;
+      copy->prev = tail;
+      tail = copy;
+      for (uint32_t i = 0; i < copy->lut_slots_count; i++)
+        lookup_table[copy->first_lut_slot + i] = copy;
+    }
+  }
+  // O(1) move, the moved-from filter can only be destroyed or assigned to
+  DFF(DFF &&other) noexcept
+      : k_initial_bits_per_item(other.k_initial_bits_per_item), k_hash_seed(other.k_hash_seed),
+        shrink_autonomously_(other.shrink_autonomously_),
+        shrink_low_water_mark_(other.shrink_low_water_mark_),
+        load_threshold_(other.load_threshold_), max_kick_rate_(other.max_kick_rate_),
+        memory_budget_(other.memory_budget_), memory_usage_(other.memory_usage_),
+        mapped_addr_(std::exchange(other.mapped_addr_, nullptr)),
+        mapped_length_(std::exchange(other.mapped_length_, 0)),
+        checkpoint_dir_(std::move(other.checkpoint_dir_)),
+        checkpoint_epoch_(other.checkpoint_epoch_),
+        table_arena_(std::exchange(other.table_arena_, nullptr)),
+        log_fd_(std::exchange(other.log_fd_, -1)), log_sync_interval_(other.log_sync_interval_),
+        log_buffer_(std::move(other.log_buffer_)),
+        head(std::exchange(other.head, nullptr)), tail(std::exchange(other.tail, nullptr)),
+        lookup_table(std::exchange(other.lookup_table, nullptr)),
+        expansion_times(std::exchange(other.expansion_times, nullptr)), k_l_log(other.k_l_log),
+        num_seg(std::exchange(other.num_seg, 0)),
+        total_expansion_time(other.total_expansion_time),
+        total_addressing_time(other.total_addressing_time) {
+    std::copy(std::begin(other.max_expansion), std::end(other.max_expansion), max_expansion);
+  }
+  auto operator=(const DFF &other) -> DFF & {
+    DFF copy(other);
+    swap(copy);
+    return *this;
+  }
+  auto operator=(DFF &&other) noexcept -> DFF & {
+    swap(other);
+    return *this;
+  }
+
+  /**
+   * @brief Create a filter.
+   *
+   * @param initial_bits_per_item Bits per item of the initial segments, ignored if `Config` fixes
+   * the bits per tag (see `Config::BITS_PER_TAG`).
+   * @param table_arena If not `nullptr`, the tag storage of all segments is allocated from it
+   * instead of the heap, e.g., in shared memory (see `SharedDFF`) or in a file for filters larger
+   * than memory (see `MappedFileArena`), and a segment cannot be expanded once it is exhausted.
+   * It must have room for the initial segments, and must outlive the filter. Copies of the filter
+   * (see `clone`) allocate from the heap. An arena never gives memory back, so segments are never
+   * merged: `merge`, `compact` and `set_shrink_autonomously` return `NotSupported`.
+   */
+  explicit DFF(const size_t initial_bits_per_item, Arena *table_arena = nullptr)
+      : DFF(initial_bits_per_item, generate_hash_seed(), table_arena) {}
 
-  explicit DFF(const size_t initial_bits_per_item)
-      : k_initial_bits_per_item(initial_bits_per_item) {
+  /**
+   * @brief Create a filter with a given hash seed instead of a random one. Filters with the same
+   * seed and initial bits per item hash every item the same way, so they can be merged (see
+   * `merge_from`) and built in different processes. Insertion uses no other randomness, so the
+   * same operations in the same order build byte-identical filters, and benchmark runs are
+   * reproducible.
+   *
+   * @param initial_bits_per_item See `DFF(size_t, Arena *)`.
+   * @param hash_seed The hash seed.
+   * @param table_arena See `DFF(size_t, Arena *)`.
+   */
+  DFF(const size_t initial_bits_per_item, const uint64_t hash_seed, Arena *table_arena = nullptr)
+      : k_initial_bits_per_item(Config::BITS_PER_TAG != 0 ? Config::BITS_PER_TAG
+                                                          : initial_bits_per_item),
+        k_hash_seed(hash_seed), table_arena_(table_arena) {
     // Initialize lookup table
     size_t counter = 0;
-    auto *cur_seg = new Segment<T, ENABLE_FINGERPRINT_GROWTH>(
-        BUCKETS_PER_SEG, k_initial_bits_per_item, k_initial_bits_per_item);
+    auto *cur_seg = new_segment(k_initial_bits_per_item);
+    memory_usage_ += segment_memory_usage(k_initial_bits_per_item);
     for (size_t i = 0; i < LOOKUP_TABLE_SIZE; i++) {
       if (head == nullptr) {
         head = cur_seg;
         tail = head;
         head->next = nullptr;
         lookup_table[i] = tail;
-        cur_seg->lut_slots[cur_seg->lut_slots_count] = i;
         cur_seg->lut_slots_count++;
       } else {
         lookup_table[i] = tail;
-        cur_seg->lut_slots[cur_seg->lut_slots_count] = i;
         cur_seg->lut_slots_count++;
       }
       counter++;
       if (counter == INITIAL_LOOKUP_TABLE_ENTRIES_PER_SEG && i != LOOKUP_TABLE_SIZE - 1) {
-        cur_seg = new Segment<T, ENABLE_FINGERPRINT_GROWTH>(
-            BUCKETS_PER_SEG, k_initial_bits_per_item, k_initial_bits_per_item);
+        cur_seg = new_segment(k_initial_bits_per_item);
+        cur_seg->first_lut_slot = i + 1;
+        memory_usage_ += segment_memory_usage(k_initial_bits_per_item);
         tail->next = cur_seg;
+        cur_seg->prev = tail;
         tail = cur_seg;
         counter = 0;
       }
@@ -159,41 +396,581 @@ public:
   }
 
   ~DFF() {
+    // Errors cannot be reported here, call `close_log` to check them
+    close_log();
     auto current = head;
     while (current != nullptr) {
       auto next = current->next;
-      delete current;
+      release_segment(current);
       current = nullptr;
       current = next;
     }
     head = tail = nullptr;
+    delete[] lookup_table;
+    delete[] expansion_times;
+#if defined(__unix__) || defined(__APPLE__)
+    // After the segments borrowing it are deleted
+    if (mapped_addr_ != nullptr)
+      ::munmap(mapped_addr_, mapped_length_);
+#endif
   }
 
   /**
-   * @brief Insert an item into the filter.
+   * @brief Create an independent deep copy of the filter. Each segment is copied with a single
+   * `memcpy` of its table, which is much faster than inserting the items again.
+   *
+   * @return The copy.
+   */
+  [[nodiscard]] auto clone() const -> DFF { return DFF(*this); }
+
+  /**
+   * @brief Take a consistent point-in-time view of the filter, e.g., to `save` it while items keep
+   * being inserted. The snapshot shares all segments with the filter, so this only copies the
+   * lookup table and takes O(number of segments) time. The filter copies a shared segment on its
+   * first modification after the snapshot (copy-on-write), so holding a snapshot costs up to one
+   * segment of memory per segment modified since, see `Snapshot::exclusive_memory_usage`.
    *
-   * Warning: If this does not return `Ok`, you should stop inserting items anymore, otherwise
-   * some inserted items may be lost, causing false negatives.
+   * A snapshot can be read by other threads while the filter keeps being modified (by a single
+   * thread, as usual). A snapshot of a filter opened with `open_mmap` must not outlive it.
    *
-   * @param item The item to insert.
-   * @return The status of the operation.
+   * @return The snapshot.
    */
-  auto insert(const T &item) -> Status {
-    uint32_t bucket_idx;
-    uint32_t hash;
-    generate_bucket_index_and_hash(item, &bucket_idx, &hash);
+  [[nodiscard]] auto snapshot() const -> Snapshot { return Snapshot(*this); }
 
-    const size_t seg_idx = segment_index(hash);
+  /**
+   * @brief Write the filter to a stream. The format (all integers in the native byte order) is:
+   *
+   * 1. A header of 64-bit integers: `FILE_MAGIC`, `FILE_VERSION`, whether fingerprint growth is
+   *    enabled, the initial bits per item, the hash seed, the geometry constants
+   *    (`LOOKUP_TABLE_SIZE`, `INITIAL_SEG_COUNT`, `BUCKETS_PER_SEG`, `SLOTS_PER_BUCKET`), whether
+   *    buckets are semi-sorted, the alternative bucket block size (see `Config::ALT_BLOCK_BUCKETS`)
+   *    and the number of segments.
+   * 2. `expansion_times` as `LOOKUP_TABLE_SIZE` 64-bit integers.
+   * 3. Every segment in list order, see `Segment::save`. The lookup table is rebuilt from the
+   *    lookup table slots of the segments.
+   *
+   * Runtime settings (automatic shrinking and memory budget) are not saved.
+   *
+   * @param os The stream to write to, should be opened in binary mode.
+   * @return The status of the operation. `IOError` if writing fails.
+   */
+  auto save(std::ostream &os) const -> Status {
+    if (!write_header(os, FILE_MAGIC))
+      return Status::IOError;
+    for (const auto *seg = head; seg != nullptr; seg = seg->next)
+      if (!seg->save(os))
+        return Status::IOError;
+    return Status::Ok;
+  }
 
-    Segment<T, ENABLE_FINGERPRINT_GROWTH> *seg = lookup_table[seg_idx];
-    Status res = seg->insert(bucket_idx, hash);
+  /**
+   * @brief Write the filter to a file, see `save(std::ostream &)`.
+   *
+   * @param path The file to write to. It is overwritten if it exists.
+   * @return The status of the operation. `IOError` if the file cannot be written.
+   */
+  auto save(const std::string &path) const -> Status {
+    std::ofstream os(path, std::ios::binary | std::ios::trunc);
+    if (!os)
+      return Status::IOError;
+    const Status res = save(os);
+    os.close();
+    return res == Status::Ok && !os ? Status::IOError : res;
+  }
 
-    if (seg->num_items > seg->capacity)
-      expand(seg_idx, seg);
+  /**
+   * @brief Replace the filter with one written by `save`. The data is validated before anything
+   * is replaced, so the filter is left untouched if this fails. Runtime settings (automatic
+   * shrinking and memory budget) of this filter are kept.
+   *
+   * @param is The stream to read from, should be opened in binary mode.
+   * @return The status of the operation. `NotSupported` if the filter was written with another
+   * format version, fingerprint growth mode or geometry, `IOError` if reading fails or the data is
+   * malformed.
+   */
+  auto load(std::istream &is) -> Status { return load_impl(is, nullptr, 0); }
+
+  /**
+   * @brief Replace the filter with one written to a file by `save`, see `load(std::istream &)`.
+   *
+   * @param path The file to read from.
+   * @return The status of the operation. `IOError` if the file cannot be read.
+   */
+  auto load(const std::string &path) -> Status {
+    std::ifstream is(path, std::ios::binary);
+    if (!is)
+      return Status::IOError;
+    return load(is);
+  }
+
+  // A tag stored in the filter, see `for_each_tag`
+  struct TagRecord {
+    // First lookup table slot of the segment holding the tag, which covers `slot_count` slots
+    // from there, i.e., the path of the segment in the split tree of its initial segment
+    uint32_t first_slot;
+    uint32_t slot_count;
+    // Bits per item of the segment
+    uint32_t bits_per_item;
+    uint32_t bucket;
+    uint32_t tag;
+    // Whether the tag is in the stash of the segment instead of a bucket, see `Segment::insert_tag`
+    bool stashed;
+  };
+
+  /**
+   * @brief Call a function for every tag stored in the filter, segment by segment in list order,
+   * and bucket by bucket within a segment, followed by the stashed tags of the segment.
+   *
+   * @param f The function, called with a `const TagRecord &`.
+   */
+  template <typename F> void for_each_tag(F &&f) const {
+    for (const auto *seg = head; seg != nullptr; seg = seg->next) {
+      TagRecord record{seg->first_lut_slot, seg->lut_slots_count,
+                       static_cast<uint32_t>(seg->k_bits_per_item), 0, 0, false};
+      for (size_t bucket = 0; bucket < BUCKETS_PER_SEG; bucket++)
+        for (size_t slot = 0; slot < SLOTS_PER_BUCKET; slot++) {
+          record.tag = seg->table->read_tag(bucket, slot);
+          record.bucket = static_cast<uint32_t>(bucket);
+          if (record.tag != 0)
+            f(static_cast<const TagRecord &>(record));
+        }
+      record.stashed = true;
+      for (const StashEntry &entry : seg->stash()) {
+        record.bucket = entry.index;
+        record.tag = entry.tag;
+        f(static_cast<const TagRecord &>(record));
+      }
+    }
+  }
+
+  /**
+   * @brief Write the tags of the filter to a stream, segment by segment, to ship the filter or to
+   * analyze its tags offline. The stream is smaller than the one written by `save` unless the
+   * segments are nearly full, and `import_tags` rebuilds the filter from it without rehashing any
+   * item or kicking any tag. The format is the header written by `save` without
+   * `expansion_times`, starting with `TAGS_MAGIC`, followed by every segment in list order, see
+   * `Segment::export_tags`.
+   *
+   * @param os The stream to write to, should be opened in binary mode.
+   * @return The status of the operation. `IOError` if writing fails.
+   */
+  auto export_tags(std::ostream &os) const -> Status {
+    if (!write_header(os, TAGS_MAGIC))
+      return Status::IOError;
+    for (const auto *seg = head; seg != nullptr; seg = seg->next)
+      if (!seg->export_tags(os))
+        return Status::IOError;
+    return Status::Ok;
+  }
+
+  /**
+   * @brief Write the tags of the filter to a file, see `export_tags(std::ostream &)`.
+   *
+   * @param path The file to write to. It is overwritten if it exists.
+   * @return The status of the operation. `IOError` if the file cannot be written.
+   */
+  auto export_tags(const std::string &path) const -> Status {
+    std::ofstream os(path, std::ios::binary | std::ios::trunc);
+    if (!os)
+      return Status::IOError;
+    const Status res = export_tags(os);
+    os.close();
+    return res == Status::Ok && !os ? Status::IOError : res;
+  }
+
+  /**
+   * @brief Replace the filter with one written by `export_tags`, in a single pass over the
+   * stream. As with `load`, the data is validated before anything is replaced, and runtime
+   * settings of this filter are kept.
+   *
+   * @param is The stream to read from, should be opened in binary mode.
+   * @return The status of the operation. `NotSupported` if the tags were written with another
+   * format version, fingerprint growth mode or geometry (semi-sorted buckets or not is fine, so
+   * this converts between the two), `IOError` if reading fails or the data is malformed.
+   */
+  auto import_tags(std::istream &is) -> Status {
+    DFF filter;
+    const Status res = read_header(is, TAGS_MAGIC, filter);
+    if (res != Status::Ok)
+      return res;
+    for (size_t i = 0; i < filter.num_seg; i++) {
+      auto *seg = Segment<T, ENABLE_FINGERPRINT_GROWTH, Config>::import_tags(
+          is, filter.k_initial_bits_per_item);
+      if (seg == nullptr)
+        return Status::IOError;
+      filter.append_segment(seg);
+      // The expansion times are not written, they follow from the lookup table slots
+      const uint32_t count = seg->lut_slots_count;
+      if (count > INITIAL_LOOKUP_TABLE_ENTRIES_PER_SEG || !std::has_single_bit(count))
+        return Status::IOError;
+      std::fill_n(filter.expansion_times + seg->first_lut_slot, count,
+                  std::countr_zero(INITIAL_LOOKUP_TABLE_ENTRIES_PER_SEG / count));
+      if (!filter.assign_lookup_table_slots(seg))
+        return Status::IOError;
+    }
+    if (!finish_loading(filter))
+      return Status::IOError;
+
+    adopt_loaded(filter);
+    return Status::Ok;
+  }
+
+  /**
+   * @brief Replace the filter with one written to a file by `export_tags`, see
+   * `import_tags(std::istream &)`.
+   *
+   * @param path The file to read from.
+   * @return The status of the operation. `IOError` if the file cannot be read.
+   */
+  auto import_tags(const std::string &path) -> Status {
+    std::ifstream is(path, std::ios::binary);
+    if (!is)
+      return Status::IOError;
+    return import_tags(is);
+  }
+
+  /**
+   * @brief Replace the filter with one written to a file by `save`, by mapping the file into
+   * memory instead of reading it. Segment tables are used in place, so this only parses the small
+   * per-segment metadata and takes milliseconds however large the filter is, and processes
+   * mapping the same file share one page cache copy of it.
+   *
+   * The mapping is private: the filter can still be modified, but changes are copied on write to
+   * the touched pages and never written back to the file. The file must not be truncated while
+   * the filter uses it. Copies of the filter (see `clone`) do not use the mapping.
+   *
+   * @param path The file to map.
+   * @return The status of the operation. `NotSupported` on platforms without `mmap` or if the
+   * file was written with another format version, fingerprint growth mode or geometry, `IOError`
+   * if the file cannot be mapped or is malformed.
+   */
+  auto open_mmap(const std::string &path) -> Status {
+#if defined(__unix__) || defined(__APPLE__)
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      return Status::IOError;
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+      ::close(fd);
+      return Status::IOError;
+    }
+    const auto length = static_cast<size_t>(st.st_size);
+    void *addr = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    // The mapping stays valid after the file is closed
+    ::close(fd);
+    if (addr == MAP_FAILED)
+      return Status::IOError;
+
+    MemoryStreamBuffer buffer(static_cast<const char *>(addr), length);
+    std::istream is(&buffer);
+    const Status res = load_impl(is, static_cast<uint8_t *>(addr), length);
+    if (res != Status::Ok)
+      ::munmap(addr, length);
+    return res;
+#else
+    return Status::NotSupported;
+#endif
+  }
+
+  /**
+   * @brief Write an incremental checkpoint of the filter to a directory. Only segments modified
+   * since the last checkpoint to the same directory are written (each to its own file), followed
+   * by a manifest of the lookup table topology naming the file of every segment, so the cost
+   * scales with the number of segments written to, not with the size of the filter. The first
+   * checkpoint to a directory writes all segments.
+   *
+   * The manifest is replaced atomically after all segment files are written and flushed to the
+   * storage device, and segment files no longer named by it are removed only once the new
+   * manifest is flushed too, so the directory always holds a complete checkpoint, even after a
+   * crash or a power loss. Runtime settings (automatic shrinking and memory budget) are not
+   * saved.
+   *
+   * @param dir The directory to write to. It is created if it does not exist.
+   * @return The status of the operation. `IOError` if writing fails, in which case the previous
+   * checkpoint is kept (along with the new one if only flushing the new manifest failed).
+   */
+  auto checkpoint(const std::string &dir) -> Status {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+    if (ec)
+      return Status::IOError;
+
+    const bool incremental = dir == checkpoint_dir_;
+    const uint64_t epoch = checkpoint_epoch_ + 1;
+    for (const auto *seg = head; seg != nullptr; seg = seg->next) {
+      if (incremental && !seg->dirty)
+        continue;
+      const fs::path path = checkpoint_segment_path(dir, seg->first_lut_slot, epoch);
+      std::ofstream os(path, std::ios::binary | std::ios::trunc);
+      if (!os || !seg->save(os))
+        return Status::IOError;
+      os.close();
+      if (!os || !sync_path(path))
+        return Status::IOError;
+    }
+
+    // Write the manifest to a temporary file first, so that the old one is replaced atomically
+    const fs::path manifest_path = checkpoint_manifest_path(dir);
+    fs::path tmp_path = manifest_path;
+    tmp_path += ".tmp";
+    {
+      std::ofstream os(tmp_path, std::ios::binary | std::ios::trunc);
+      if (!os || !write_header(os, CHECKPOINT_MAGIC) || !write_pod(os, epoch))
+        return Status::IOError;
+      for (const auto *seg = head; seg != nullptr; seg = seg->next) {
+        const uint64_t entry[] = {seg->first_lut_slot,
+                                  incremental && !seg->dirty ? seg->checkpoint_epoch : epoch};
+        if (!write_bytes(os, entry, sizeof(entry)))
+          return Status::IOError;
+      }
+      os.close();
+      if (!os || !sync_path(tmp_path))
+        return Status::IOError;
+    }
+    fs::rename(tmp_path, manifest_path, ec);
+    if (ec)
+      return Status::IOError;
+    const bool renamed_durably = sync_path(dir);
+
+    std::unordered_set<std::string> live_files;
+    for (auto *seg = head; seg != nullptr; seg = seg->next) {
+      if (!incremental || seg->dirty) {
+        seg->dirty = false;
+        seg->checkpoint_epoch = epoch;
+      }
+      live_files.insert(
+          checkpoint_segment_path(dir, seg->first_lut_slot, seg->checkpoint_epoch)
+              .filename()
+              .string());
+    }
+    checkpoint_dir_ = dir;
+    checkpoint_epoch_ = epoch;
+
+    // The files of the previous checkpoint are kept until the new manifest is durable
+    if (!renamed_durably)
+      return Status::IOError;
+
+    // Remove files of segments rewritten or deleted since the last checkpoint. Failing to do so
+    // only wastes space.
+    for (const auto &entry : fs::directory_iterator(dir, ec)) {
+      const std::string filename = entry.path().filename().string();
+      if (filename.starts_with("segment_") && !live_files.contains(filename))
+        fs::remove(entry.path(), ec);
+    }
+
+    return Status::Ok;
+  }
+
+  /**
+   * @brief Replace the filter with the last checkpoint written to a directory by `checkpoint`, by
+   * replaying its manifest. The filter is left untouched if this fails. Later checkpoints of the
+   * filter to the same directory are incremental again. Runtime settings (automatic shrinking and
+   * memory budget) of this filter are kept.
+   *
+   * @param dir The directory to read from.
+   * @return The status of the operation. `NotSupported` if the checkpoint was written with
+   * another format version, fingerprint growth mode or geometry, `IOError` if reading fails or
+   * the checkpoint is malformed.
+   */
+  auto restore(const std::string &dir) -> Status {
+    std::ifstream manifest(checkpoint_manifest_path(dir), std::ios::binary);
+    if (!manifest)
+      return Status::IOError;
+
+    DFF filter;
+    const Status res = read_header(manifest, CHECKPOINT_MAGIC, filter);
+    if (res != Status::Ok)
+      return res;
+    uint64_t epoch;
+    if (!read_pod(manifest, epoch))
+      return Status::IOError;
+    for (size_t i = 0; i < filter.num_seg; i++) {
+      uint64_t entry[2];
+      if (!read_bytes(manifest, entry, sizeof(entry)))
+        return Status::IOError;
+      const auto [slot, seg_epoch] = entry;
+      std::ifstream is(checkpoint_segment_path(dir, slot, seg_epoch), std::ios::binary);
+      if (!is)
+        return Status::IOError;
+      auto *seg =
+          Segment<T, ENABLE_FINGERPRINT_GROWTH, Config>::load(is, filter.k_initial_bits_per_item);
+      if (seg == nullptr)
+        return Status::IOError;
+      seg->dirty = false;
+      seg->checkpoint_epoch = seg_epoch;
+      filter.append_segment(seg);
+      if (!filter.assign_lookup_table_slots(seg) || seg->first_lut_slot != slot)
+        return Status::IOError;
+    }
+    if (!finish_loading(filter))
+      return Status::IOError;
+
+    filter.checkpoint_dir_ = dir;
+    filter.checkpoint_epoch_ = epoch;
+    adopt_loaded(filter);
+    return Status::Ok;
+  }
+
+  /**
+   * @brief Start logging insertions and removals to an append-only file, so that operations after
+   * the last `save` or `checkpoint` survive a crash: recover by loading the filter and calling
+   * `replay_log`. Each entry holds the 64-bit hash of the item instead of the item, so entries
+   * have a fixed size and replaying skips hashing.
+   *
+   * Entries are buffered and written with a single `fdatasync` once `sync_interval` of them are
+   * pending (group commit), trading the durability of the last `sync_interval - 1` operations for
+   * far fewer syncs. `sync_log` writes the pending entries immediately.
+   *
+   * The log is bound to the hash seed of the filter. An existing log is appended to after
+   * dropping a torn entry left by a crash. Copies of the filter do not log, and `load`,
+   * `open_mmap`, `restore` and `import_tags` close the log, since the loaded filter has another
+   * hash seed.
+   *
+   * @param path The log file.
+   * @param sync_interval Number of operations per group commit, 1 to sync every operation.
+   * @param truncate Whether to discard the entries of an existing log, e.g., after a checkpoint.
+   * @return The status of the operation. `NotSupported` on platforms without POSIX file I/O, if
+   * `sync_interval` is 0 or if the log was written by a filter with another hash seed or
+   * fingerprint growth mode, `IOError` if the file cannot be opened or is malformed.
+   */
+  auto open_log(const std::string &path, const size_t sync_interval = 1,
+                const bool truncate = false) -> Status {
+#if defined(__unix__) || defined(__APPLE__)
+    if (sync_interval == 0)
+      return Status::NotSupported;
+    if (const Status res = close_log(); res != Status::Ok)
+      return res;
+
+    const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND | (truncate ? O_TRUNC : 0),
+                          0644);
+    if (fd < 0)
+      return Status::IOError;
+    const Status res = prepare_log(fd);
+    if (res != Status::Ok) {
+      ::close(fd);
+      return res;
+    }
+
+    log_fd_ = fd;
+    log_sync_interval_ = sync_interval;
+    log_buffer_.reserve(sync_interval * LOG_ENTRY_SIZE);
+    return Status::Ok;
+#else
+    return Status::NotSupported;
+#endif
+  }
+
+  /**
+   * @brief Write the log entries pending for the next group commit and sync them, see `open_log`.
+   *
+   * @return The status of the operation. `IOError` if writing fails, in which case the pending
+   * entries are dropped.
+   */
+  auto sync_log() -> Status {
+#if defined(__unix__) || defined(__APPLE__)
+    if (log_fd_ < 0 || log_buffer_.empty())
+      return Status::Ok;
+    const bool written = write_fully(log_fd_, log_buffer_.data(), log_buffer_.size()) &&
+                         sync_file(log_fd_);
+    log_buffer_.clear();
+    return written ? Status::Ok : Status::IOError;
+#else
+    return Status::Ok;
+#endif
+  }
+
+  /**
+   * @brief Sync the pending log entries and stop logging, see `open_log`.
+   *
+   * @return The status of the operation. `IOError` if syncing fails.
+   */
+  auto close_log() -> Status {
+#if defined(__unix__) || defined(__APPLE__)
+    if (log_fd_ < 0)
+      return Status::Ok;
+    Status res = sync_log();
+    if (::close(log_fd_) != 0)
+      res = Status::IOError;
+    log_fd_ = -1;
+    return res;
+#else
+    return Status::Ok;
+#endif
+  }
+
+  /**
+   * @brief Apply the operations recorded by `open_log` to the filter, which should be the filter
+   * as it was when the log was opened (e.g., loaded from a `save` or `checkpoint` made then).
+   * The log is validated before anything is applied, and a torn entry at its end is ignored.
+   *
+   * Instead of applying entries one by one, each batch of entries is partitioned by segment with
+   * a counting sort and applied segment by segment, so every segment stays in cache while its
+   * entries are applied. The partition is stable, so the operations on a segment keep their log
+   * order. With automatic shrinking, a removal may merge segments, so batches are applied as
+   * logged instead. Operations are not logged again if the filter has a log open.
+   *
+   * @param path The log file.
+   * @return The status of the operation. `NotSupported` if the log was written by a filter with
+   * another hash seed or fingerprint growth mode, `IOError` if the file cannot be read or is
+   * malformed, or the status of the first failed insertion (removals of absent items are
+   * ignored, as they failed when logged as well).
+   */
+  auto replay_log(const std::string &path) -> Status {
+    std::ifstream is(path, std::ios::binary);
+    if (!is)
+      return Status::IOError;
+    uint64_t header[4];
+    if (!read_bytes(is, header, sizeof(header)))
+      return Status::IOError;
+    if (const Status res = check_log_header(header); res != Status::Ok)
+      return res;
+    const std::vector<uint8_t> entries{std::istreambuf_iterator<char>(is),
+                                       std::istreambuf_iterator<char>()};
+    if (is.bad())
+      return Status::IOError;
 
+    const size_t num_entries = entries.size() / LOG_ENTRY_SIZE;
+    for (size_t i = 0; i < num_entries; i++) {
+      const auto op = static_cast<LogOp>(entries[i * LOG_ENTRY_SIZE + sizeof(uint64_t)]);
+      if (op != LogOp::Insert && op != LogOp::Remove)
+        return Status::IOError;
+    }
+
+    Status res = Status::Ok;
+    std::vector<uint32_t> order;
+    for (size_t begin = 0; begin < num_entries; begin += LOG_REPLAY_BATCH_SIZE) {
+      const size_t end = std::min(begin + LOG_REPLAY_BATCH_SIZE, num_entries);
+      const Status batch_res = replay_log_batch(entries.data() + begin * LOG_ENTRY_SIZE,
+                                                end - begin, order);
+      if (res == Status::Ok)
+        res = batch_res;
+    }
     return res;
   }
 
+  /**
+   * @brief Insert an item into the filter.
+   *
+   * Warning: If this does not return `Ok`, the item is not inserted, and you should stop inserting
+   * items anymore, otherwise the false positive rate may become very high.
+   *
+   * With a memory budget set (see `set_memory_budget`), segments that cannot be expanded keep
+   * taking items beyond their capacity, and an item that does not fit any more is kept by
+   * saturating the segment, so this always returns `Ok` at the cost of a higher false positive
+   * rate (see `predicted_false_positive_rate`).
+   *
+   * @param item The item to insert.
+   * @return The status of the operation. `IOError` if the insertion cannot be logged (see
+   * `open_log`), in which case the item is not inserted.
+   */
+  auto insert(const T &item) -> Status {
+    const uint64_t full_hash = DFF::hash(item, k_hash_seed);
+    if (log_fd_ >= 0 && append_log(LogOp::Insert, full_hash) != Status::Ok)
+      return Status::IOError;
+    return insert_hashed(full_hash);
+  }
+
   /**
    * @brief Query if an item is in the filter, with false positive rate.
    *
@@ -223,14 +1000,170 @@ public:
    * @brief Remove an item from the filter.
    *
    * @param item The item to remove.
-   * @return Status of the operation.
+   * @return Status of the operation. `IOError` if the removal cannot be logged (see `open_log`),
+   * in which case the item is not removed.
    */
   auto remove(const T &item) -> Status {
-    uint32_t bucket_idx;
-    uint32_t hash;
-    generate_bucket_index_and_hash(item, &bucket_idx, &hash);
+    const uint64_t full_hash = DFF::hash(item, k_hash_seed);
+    if (log_fd_ >= 0 && append_log(LogOp::Remove, full_hash) != Status::Ok)
+      return Status::IOError;
+    return remove_hashed(full_hash);
+  }
+
+  /**
+   * @brief Enable or disable merging sibling segments automatically on `remove`. Two siblings are
+   * merged once they hold at most `low_water_mark * capacity` items in total.
+   *
+   * A segment is expanded when it holds more than `capacity` items, after which the two siblings
+   * hold `capacity` items in total, so a low-water mark of at most 0.5 leaves a gap of at least
+   * half a segment between merging and expanding again, preventing the filter from thrashing
+   * between the two under an oscillating load.
+   *
+   * @param enabled Whether to shrink automatically.
+   * @param low_water_mark Fraction of a segment's capacity below which two siblings are merged.
+   * @return The status of the operation. `NotSupported` if `low_water_mark` is not in (0, 0.5], or
+   * if enabling it with a table arena (see `DFF(size_t, Arena *)`).
+   */
+  auto set_shrink_autonomously(const bool enabled,
+                               const double low_water_mark = DEFAULT_SHRINK_LOW_WATER_MARK)
+      -> Status {
+    if (low_water_mark <= 0.0 || low_water_mark > 0.5 || (enabled && table_arena_ != nullptr))
+      return Status::NotSupported;
+    shrink_autonomously_ = enabled;
+    shrink_low_water_mark_ = low_water_mark;
+    return Status::Ok;
+  }
+
+  /**
+   * @brief Set the load threshold: a segment is expanded once it holds more than this fraction of
+   * its slots. A higher threshold uses fewer bits per item, at the cost of slower insertions, as
+   * cuckoo paths get longer when a segment fills up. Applies to existing segments as well, and is
+   * not in effect while adaptive expansion is enabled (see `set_adaptive_expansion`).
+   *
+   * @param load_threshold Fraction of the slots of a segment, 0.9 by default.
+   * @return The status of the operation. `NotSupported` if `load_threshold` is not in [0.5, 0.95].
+   */
+  auto set_load_threshold(const double load_threshold) -> Status {
+    if (load_threshold < MIN_LOAD_THRESHOLD || load_threshold > MAX_LOAD_THRESHOLD)
+      return Status::NotSupported;
+    load_threshold_ = load_threshold;
+    apply_load_threshold();
+    return Status::Ok;
+  }
+
+  /**
+   * @brief Enable or disable adaptive expansion. Instead of at the load threshold, a segment is
+   * then expanded once its insertions get expensive, i.e., once the number of tags moved per
+   * insertion averaged over its recent insertions (`Segment::kick_rate`) exceeds `max_kick_rate`,
+   * or once it holds 95% of its slots. Segments are thus expanded early if their items collide
+   * more than usual, and fill up further while insertions stay cheap. With evenly spread items,
+   * the default kick rate is exceeded at about 91% load and a rate of 1.5 at about 95%.
+   *
+   * @param enabled Whether to expand segments adaptively.
+   * @param max_kick_rate Average number of tags moved per insertion beyond which a segment is
+   * expanded.
+   * @return The status of the operation. `NotSupported` if `max_kick_rate` is not positive.
+   */
+  auto set_adaptive_expansion(const bool enabled,
+                              const double max_kick_rate = DEFAULT_MAX_KICK_RATE) -> Status {
+    if (max_kick_rate <= 0.0)
+      return Status::NotSupported;
+    max_kick_rate_ = enabled ? max_kick_rate : 0.0;
+    apply_load_threshold();
+    return Status::Ok;
+  }
+
+  /**
+   * @brief Set a hard cap on the memory used by the filter. Once expanding a segment would exceed
+   * the budget, the filter stops allocating and degrades gracefully instead: segments keep taking
+   * items beyond their capacity, then keep the items they cannot place in their stash, and
+   * finally saturate (answer every query positively) while they count items they lost. No false
+   * negatives are introduced, only the false positive rate grows (see
+   * `predicted_false_positive_rate`). A segment stops being saturated once as many removals as it
+   * lost items have not found their item in it. Without a budget, segments never saturate and an
+   * item that does not fit is not inserted.
+   *
+   * @param bytes The memory budget in bytes, or 0 for unlimited (the default).
+   */
+  void set_memory_budget(const size_t bytes) { memory_budget_ = bytes; }
 
-    return lookup_table[segment_index(hash)]->remove(bucket_idx, hash);
+  /**
+   * @brief Get the memory used by the filter and its segments.
+   *
+   * @return The memory usage in bytes.
+   */
+  [[nodiscard]] auto memory_usage() const -> size_t { return memory_usage_; }
+
+  /**
+   * @brief Get the hash seed of the filter, given to the constructor or drawn randomly, and kept
+   * by `save` and `load`.
+   *
+   * @return The hash seed.
+   */
+  [[nodiscard]] auto hash_seed() const -> uint64_t { return k_hash_seed; }
+
+  /**
+   * @brief Predict the false positive rate of the filter from the load and effective fingerprint
+   * length of each segment. A query is routed to a segment with a probability proportional to the
+   * number of lookup table slots it occupies, and compared with the `2 * SLOTS_PER_BUCKET` tags of
+   * its two candidate buckets.
+   *
+   * @return The predicted false positive rate.
+   */
+  [[nodiscard]] auto predicted_false_positive_rate() const -> double {
+    constexpr auto SLOTS_PER_SEG = static_cast<double>(BUCKETS_PER_SEG * SLOTS_PER_BUCKET);
+    double res = 0.0;
+    for (const auto *seg = head; seg != nullptr; seg = seg->next) {
+      double seg_fpr = 1.0;
+      if (!seg->saturated()) {
+        const double load = std::min(1.0, static_cast<double>(seg->num_items) / SLOTS_PER_SEG);
+        // The high bits of the fingerprints in a segment are all the same as the ones used to
+        // address the segment, so they do not help to tell the items apart
+        const size_t expansion_time = expansion_times[seg->first_lut_slot];
+        const size_t effective_bits =
+            seg->k_bits_per_item > expansion_time ? seg->k_bits_per_item - expansion_time : 0;
+        const double tag_fpr = std::pow(2.0, -static_cast<double>(effective_bits));
+        seg_fpr = 1.0 - std::pow(1.0 - tag_fpr, 2.0 * SLOTS_PER_BUCKET * load);
+      }
+      res += seg_fpr * static_cast<double>(seg->lut_slots_count) / LOOKUP_TABLE_SIZE;
+    }
+    return res;
+  }
+
+  /**
+   * @brief Pre-size the filter for `n` items, so that inserting them does not trigger any
+   * expansion (short of a very unlikely spread of the items, or of adaptive expansion, see
+   * `set_adaptive_expansion`). Every segment is split up front until the segments of each initial
+   * group can hold their share of `n` items. Empty segments are split without scanning their
+   * tables, so this is much cheaper than the expansions it saves, especially on a new filter.
+   *
+   * Items are spread evenly over the lookup table, so all segments of a group are split to the
+   * same depth. The number of items a segment gets is random though (binomially distributed), so
+   * the segments are split until their capacity also covers `RESERVE_LOAD_STD_DEVS` standard
+   * deviations above their share. The depth is bounded by the number of lookup table slots of a
+   * group, beyond which inserting the items may expand segments again.
+   *
+   * @param n The number of items to reserve space for.
+   * @return The status of the operation. `NotEnoughSpace` if the memory budget is reached before
+   * all segments are allocated (the segments allocated so far are kept).
+   */
+  auto reserve(const size_t n) -> Status {
+    const auto capacity = static_cast<double>(head->capacity);
+    size_t depth = 0;
+    for (; depth < k_l_log; depth++) {
+      const double share = static_cast<double>(n) / static_cast<double>(INITIAL_SEG_COUNT << depth);
+      if (share + RESERVE_LOAD_STD_DEVS * std::sqrt(share) <= capacity)
+        break;
+    }
+
+    for (size_t i = 0; i < LOOKUP_TABLE_SIZE; i++)
+      while (expansion_times[i] < depth) {
+        const Status res = expand(i, lookup_table[i]);
+        if (res != Status::Ok)
+          return res;
+      }
+
+    return Status::Ok;
   }
 
   /**
@@ -238,23 +1171,30 @@ public:
    *
    * @param seg_idx The index of the segment to expand.
    * @param seg The segment to expand.
-   * @return The status of the operation.
+   * @return The status of the operation. `NotEnoughSpace` if the new segment would exceed the
+   * memory budget or the table arena is exhausted.
    */
-  auto expand(const size_t seg_idx, Segment<T, ENABLE_FINGERPRINT_GROWTH> *seg) -> Status {
+  auto expand(const size_t seg_idx, Segment<T, ENABLE_FINGERPRINT_GROWTH, Config> *seg) -> Status {
     double start;
     if constexpr (BENCHMARK_TRACK_EXPANSION_TIME)
       start = get_current_time_in_seconds();
 
-    const size_t seg_bits_per_item = seg->k_bits_per_item;
-    auto *new_seg = new Segment<T, ENABLE_FINGERPRINT_GROWTH>(
-        BUCKETS_PER_SEG,
-        ENABLE_FINGERPRINT_GROWTH ? seg_bits_per_item + 1 : k_initial_bits_per_item,
-        k_initial_bits_per_item);
-    num_seg++;
     if (seg->lut_slots_count < 2)
       return Status::NotSupported;
-    tail->next = new_seg;
-    tail = new_seg;
+    if (memory_budget_ != 0 &&
+        memory_usage_ + segment_memory_usage(expanded_bits_per_item(seg)) > memory_budget_)
+      return Status::NotEnoughSpace;
+
+    auto *new_seg = new_segment(expanded_bits_per_item(seg));
+    if (new_seg == nullptr)
+      return Status::NotEnoughSpace;
+    seg = writable_segment(seg);
+    seg->kick_rate = 0.0;
+    const size_t seg_bits_per_item = seg->k_bits_per_item;
+    // Items lost by a saturated segment may belong to either half, so both keep counting them
+    new_seg->num_lost = seg->num_lost;
+    num_seg++;
+    append_segment(new_seg);
     const uint32_t index1 = (seg->lut_slots_count) >> 1;
     const uint32_t index2 = seg->lut_slots_count;
     const size_t expansion_time = expansion_times[seg_idx];
@@ -265,60 +1205,65 @@ public:
     //              num_seg - 1, num_seg, seg->num_items, seg->capacity,
     //              seg_bits_per_item, seg_bits_per_item + 1, expansion_time);
 
-    // Move half of the items to the new segment
-    for (size_t bucket = 0; bucket < BUCKETS_PER_SEG; bucket++)
+    // Move half of the items to the new segment (nothing to scan in an empty one, e.g., when
+    // called by `reserve`). Each bucket is split as a whole, so that a semi-sorted bucket is
+    // decoded once, and the two halves encoded once each
+    for (size_t bucket = 0; bucket < BUCKETS_PER_SEG && seg->num_items != 0; bucket++) {
+      uint32_t tags[SLOTS_PER_BUCKET];
+      uint32_t moved_tags[SLOTS_PER_BUCKET] = {};
+      bool any_removed = false;
+      bool any_moved = false;
+      seg->table->read_bucket(bucket, tags);
       for (size_t slot = 0; slot < SLOTS_PER_BUCKET; slot++) {
-        const uint32_t tag = seg->table->read_tag(bucket, slot);
+        const uint32_t tag = tags[slot];
         if (tag != 0) {
           bool should_move;
           bool should_remove;
-          // `should_remove` is usually true if `should_move` is true, but false
-          // when fingerprint length is exhausted, and in such case the tag will
-          // be kept in both segments
-          if constexpr (ENABLE_FINGERPRINT_GROWTH) {
-            if (expansion_time >= seg_bits_per_item - __builtin_ctz(tag)) {
-              // spdlog::warn("Fingerprint length exhausted. tag: {}, expansion_time: {}", tag,
-              //              expansion_time);
-              should_remove = false;
-              should_move = true;
-            } else {
-              should_remove = should_move =
-                  ((tag >> (seg_bits_per_item - expansion_time)) & 1) == 1;
-            }
-          } else {
-            if (expansion_time + 1 >= k_initial_bits_per_item) {
-              should_remove = false;
-              should_move = true;
-            } else {
-              should_remove = should_move =
-                  ((tag >> (k_initial_bits_per_item - 1 - expansion_time)) & 1) == 1;
-            }
-          }
+          split_tag(tag, seg_bits_per_item, expansion_time, should_move, should_remove);
           if (should_remove) {
-            seg->table->remove_tag(bucket, slot);
+            tags[slot] = 0;
             seg->num_items--;
+            any_removed = true;
           }
           if (should_move) {
-            if constexpr (ENABLE_FINGERPRINT_GROWTH)
-              new_seg->table->write_tag(bucket, slot, tag << 1);
-            else
-              new_seg->table->write_tag(bucket, slot, tag);
+            moved_tags[slot] = ENABLE_FINGERPRINT_GROWTH ? tag << 1 : tag;
             new_seg->num_items++;
+            any_moved = true;
           }
         }
       }
+      if (any_removed)
+        seg->table->write_bucket(bucket, tags);
+      if (any_moved)
+        new_seg->table->write_bucket(bucket, moved_tags);
+    }
 
-    // Assign half of the lookup table slots to the new segment
-    for (size_t i = index1; i < index2; i++) {
-      new_seg->lut_slots[new_seg->lut_slots_count] = seg->lut_slots[i];
-      new_seg->lut_slots_count++;
-      lookup_table[seg->lut_slots[i]] = new_seg;
+    // Stashed tags are not stored in the table, so move them separately, into the table if there
+    // is room now
+    StashEntry stashed[STASH_SIZE];
+    const size_t num_stashed = seg->take_stash(stashed);
+    for (size_t i = 0; i < num_stashed; i++) {
+      const auto [bucket, tag] = stashed[i];
+      bool should_move;
+      bool should_remove;
+      split_tag(tag, seg_bits_per_item, expansion_time, should_move, should_remove);
+      if (!should_remove)
+        seg->insert_tag(bucket, tag);
+      if (should_move)
+        new_seg->insert_tag(bucket, ENABLE_FINGERPRINT_GROWTH ? tag << 1 : tag);
     }
+
+    // Assign half of the lookup table slots to the new segment
+    new_seg->first_lut_slot = seg->first_lut_slot + index1;
+    new_seg->lut_slots_count = index2 - index1;
+    for (size_t i = index1; i < index2; i++)
+      lookup_table[seg->first_lut_slot + i] = new_seg;
     for (size_t i = 0; i < index2; i++)
-      expansion_times[seg->lut_slots[i]]++;
+      expansion_times[seg->first_lut_slot + i]++;
     max_expansion[seg_idx / INITIAL_LOOKUP_TABLE_ENTRIES_PER_SEG] = std::max(
         expansion_times[seg_idx], max_expansion[seg_idx / INITIAL_LOOKUP_TABLE_ENTRIES_PER_SEG]);
     seg->lut_slots_count = index1;
+    seg->dirty = true;
 
     if constexpr (BENCHMARK_TRACK_EXPANSION_TIME)
       total_expansion_time += get_current_time_in_seconds() - start;
@@ -327,14 +1272,984 @@ public:
   }
 
   /**
-   * @brief Compact the filter.
+   * @brief Merge a segment with its sibling (the inverse of `expand`). The sibling is the segment
+   * occupying the other half of the lookup table slots the two segments were split from. The upper
+   * segment is folded into the lower one and deleted.
+   *
+   * @param seg Either of the two siblings.
+   * @param load_factor Merge only if the two siblings hold at most `load_factor * capacity` items
+   * in total.
+   * @return The status of the operation. `NotSupported` if the segment has no sibling to merge
+   * with (it is an initial segment, or its sibling has been expanded again) or with a table arena
+   * (see `DFF(size_t, Arena *)`), `NotEnoughSpace` if the items of the two siblings do not fit.
+   */
+  auto merge(Segment<T, ENABLE_FINGERPRINT_GROWTH, Config> *seg,
+             const double load_factor = DEFAULT_COMPACT_LOAD_FACTOR) -> Status {
+    auto *sibling = sibling_of(seg);
+    if (sibling == nullptr || table_arena_ != nullptr)
+      return Status::NotSupported;
+    if (!fits_in_one_segment(seg, sibling, load_factor))
+      return Status::NotEnoughSpace;
+
+    const bool seg_is_lower = seg->first_lut_slot < sibling->first_lut_slot;
+    const Status res = seg_is_lower ? fold_siblings(seg, sibling) : fold_siblings(sibling, seg);
+    if (res != Status::Ok)
+      return res;
+
+    delete_folded_segments();
+    return Status::Ok;
+  }
+
+  /**
+   * @brief Compact the filter by merging sibling segments whose items fit in a single segment,
+   * repeatedly, until no more siblings can be merged. Useful to give memory back after a large
+   * number of deletions.
+   *
+   * @param load_factor Merge two siblings only if they hold at most `load_factor * capacity` items
+   * in total.
+   * @return The status of the operation. `NotSupported` with a table arena (see
+   * `DFF(size_t, Arena *)`).
+   */
+  auto compact(const double load_factor = DEFAULT_COMPACT_LOAD_FACTOR) -> Status {
+    // The merged tables would be allocated from the heap, and the arena never gives memory back
+    if (table_arena_ != nullptr)
+      return Status::NotSupported;
+
+    size_t merged_count;
+    do {
+      merged_count = 0;
+      for (auto *seg = head; seg != nullptr; seg = seg->next) {
+        // Already folded into its sibling in this pass
+        if (is_folded(seg))
+          continue;
+        auto *sibling = sibling_of(seg);
+        // Each pair is handled from its lower segment
+        if (sibling == nullptr || sibling->first_lut_slot < seg->first_lut_slot)
+          continue;
+        if (!fits_in_one_segment(seg, sibling, load_factor))
+          continue;
+        // Keep iterating from the segment in the list if it is copied on write
+        seg = writable_segment(seg);
+        if (fold_siblings(seg, sibling) == Status::Ok)
+          merged_count++;
+      }
+      delete_folded_segments();
+    } while (merged_count != 0);
+
+    return Status::Ok;
+  }
+
+  /**
+   * @brief Merge the items of another filter into this one, e.g., to combine filters built per
+   * partition. The filters must share the hash seed and the initial bits per item (see
+   * `DFF(size_t, uint64_t, Arena *)`). No item is rehashed: the tags of each segment of `other`
+   * are inserted into the segments of this filter covering the same lookup table slots, after
+   * expanding the segment of this filter until it is not larger. Where this filter is split
+   * further, each tag is sent down the same way `expand` moves it. Segments of this filter are
+   * expanded as usual when they exceed their capacity.
+   *
+   * The merged items are not written to the operation log (see `open_log`), so merging is not
+   * supported while the log is open.
+   *
+   * @param other The filter to merge. It is not modified.
+   * @return The status of the operation. `NotSupported` if the filters do not share the hash seed
+   * and the initial bits per item, if `other` is this filter or if the log is open,
+   * `NotEnoughSpace` if some tags do not fit, which are then left out as after a failed `insert`
+   * (with a memory budget, the segments taking them saturate instead and `Ok` is returned).
+   */
+  auto merge_from(const DFF &other) -> Status {
+    if (&other == this || other.k_hash_seed != k_hash_seed ||
+        other.k_initial_bits_per_item != k_initial_bits_per_item || log_fd_ >= 0)
+      return Status::NotSupported;
+
+    Status res = Status::Ok;
+    for (const auto *other_seg = other.head; other_seg != nullptr; other_seg = other_seg->next) {
+      const uint32_t first_slot = other_seg->first_lut_slot;
+      const uint32_t count = other_seg->lut_slots_count;
+      // Align the two split trees, the tags are still inserted into a larger segment on failure
+      while (lookup_table[first_slot]->lut_slots_count > count &&
+             expand(first_slot, lookup_table[first_slot]) == Status::Ok)
+        ;
+
+      // The items lost by a saturated segment may belong to any segment taking its slots, each
+      // of which counts them once
+      if (other_seg->saturated())
+        for (uint32_t i = 0; i < count; i += lookup_table[first_slot + i]->lut_slots_count)
+          writable_segment(lookup_table[first_slot + i])->num_lost += other_seg->num_lost;
+
+      for (size_t bucket = 0; bucket < BUCKETS_PER_SEG; bucket++)
+        for (size_t slot = 0; slot < SLOTS_PER_BUCKET; slot++) {
+          const uint32_t tag = other_seg->table->read_tag(bucket, slot);
+          if (tag != 0 &&
+              merge_tag(bucket, tag, other_seg->k_bits_per_item, first_slot, count) != Status::Ok)
+            res = Status::NotEnoughSpace;
+        }
+      for (const StashEntry &entry : other_seg->stash())
+        if (merge_tag(entry.index, entry.tag, other_seg->k_bits_per_item, first_slot, count) !=
+            Status::Ok)
+          res = Status::NotEnoughSpace;
+    }
+
+    if (res == Status::NotEnoughSpace && memory_budget_ != 0)
+      return Status::Ok;
+    return res;
+  }
+
+private:
+  // An empty filter without any segment, to be filled by `load`
+  DFF() : k_initial_bits_per_item(0) {
+    std::fill(lookup_table, lookup_table + LOOKUP_TABLE_SIZE, nullptr);
+  }
+
+  void swap(DFF &other) noexcept {
+    std::swap(k_initial_bits_per_item, other.k_initial_bits_per_item);
+    std::swap(k_hash_seed, other.k_hash_seed);
+    std::swap(shrink_autonomously_, other.shrink_autonomously_);
+    std::swap(shrink_low_water_mark_, other.shrink_low_water_mark_);
+    std::swap(load_threshold_, other.load_threshold_);
+    std::swap(max_kick_rate_, other.max_kick_rate_);
+    std::swap(memory_budget_, other.memory_budget_);
+    std::swap(memory_usage_, other.memory_usage_);
+    std::swap(mapped_addr_, other.mapped_addr_);
+    std::swap(mapped_length_, other.mapped_length_);
+    std::swap(checkpoint_dir_, other.checkpoint_dir_);
+    std::swap(checkpoint_epoch_, other.checkpoint_epoch_);
+    std::swap(table_arena_, other.table_arena_);
+    std::swap(log_fd_, other.log_fd_);
+    std::swap(log_sync_interval_, other.log_sync_interval_);
+    std::swap(log_buffer_, other.log_buffer_);
+    std::swap(head, other.head);
+    std::swap(tail, other.tail);
+    std::swap(lookup_table, other.lookup_table);
+    std::swap(expansion_times, other.expansion_times);
+    std::swap(max_expansion, other.max_expansion);
+    std::swap(k_l_log, other.k_l_log);
+    std::swap(num_seg, other.num_seg);
+    std::swap(total_expansion_time, other.total_expansion_time);
+    std::swap(total_addressing_time, other.total_addressing_time);
+  }
+
+  /**
+   * @brief Insert an item by its full hash, see `insert`.
+   *
+   * @param full_hash The full hash of the item.
+   * @return The status of the operation.
+   */
+  auto insert_hashed(const uint64_t full_hash) -> Status {
+    uint32_t bucket_idx;
+    uint32_t hash;
+    split_hash(full_hash, &bucket_idx, &hash);
+
+    const size_t seg_idx = segment_index(hash);
+
+    Segment<T, ENABLE_FINGERPRINT_GROWTH, Config> *seg = writable_segment(lookup_table[seg_idx]);
+    const uint64_t num_kicks = seg->num_kicks;
+    Status res = seg->insert(bucket_idx, hash);
+    // Under a memory budget, the item is kept by saturating the segment
+    if (res == Status::NotEnoughSpace && memory_budget_ != 0)
+      seg->num_lost++;
+    if (max_kick_rate_ != 0.0)
+      seg->kick_rate += (static_cast<double>(seg->num_kicks - num_kicks) - seg->kick_rate) *
+                        KICK_RATE_WEIGHT;
+
+    if (should_expand(seg))
+      expand(seg_idx, seg);
+
+    if (res == Status::NotEnoughSpace && memory_budget_ != 0)
+      return Status::Ok;
+    return res;
+  }
+
+  /**
+   * @brief Remove an item by its full hash, see `remove`.
+   *
+   * @param full_hash The full hash of the item.
+   * @return The status of the operation.
+   */
+  auto remove_hashed(const uint64_t full_hash) -> Status {
+    uint32_t bucket_idx;
+    uint32_t hash;
+    split_hash(full_hash, &bucket_idx, &hash);
+
+    Segment<T, ENABLE_FINGERPRINT_GROWTH, Config> *seg =
+        writable_segment(lookup_table[segment_index(hash)]);
+    const Status res = seg->remove(bucket_idx, hash);
+
+    // The sibling pair can only be below the low-water mark if this segment is
+    if (shrink_autonomously_ && res == Status::Ok &&
+        static_cast<double>(seg->num_items) <=
+            shrink_low_water_mark_ * static_cast<double>(seg->capacity))
+      merge(seg, shrink_low_water_mark_);
+
+    return res;
+  }
+
+  /**
+   * @brief Check the header of a log written by `open_log` against this filter.
+   *
+   * @param header The header.
+   * @return The status of the check.
+   */
+  [[nodiscard]] auto check_log_header(const uint64_t (&header)[4]) const -> Status {
+    const auto [magic, version, fingerprint_growth, hash_seed] = header;
+    if (magic != LOG_MAGIC)
+      return Status::IOError;
+    if (version != FILE_VERSION || fingerprint_growth != ENABLE_FINGERPRINT_GROWTH ||
+        hash_seed != k_hash_seed)
+      return Status::NotSupported;
+    return Status::Ok;
+  }
+
+  /**
+   * @brief Append an entry to the log, writing and syncing the pending entries once
+   * `log_sync_interval_` of them are pending.
+   *
+   * @param op The operation.
+   * @param full_hash The full hash of the item.
+   * @return The status of the operation.
+   */
+  auto append_log(const LogOp op, const uint64_t full_hash) -> Status {
+    uint8_t entry[LOG_ENTRY_SIZE];
+    memcpy(entry, &full_hash, sizeof(full_hash));
+    entry[sizeof(full_hash)] = static_cast<uint8_t>(op);
+    log_buffer_.insert(log_buffer_.end(), std::begin(entry), std::end(entry));
+    if (log_buffer_.size() >= log_sync_interval_ * LOG_ENTRY_SIZE)
+      return sync_log();
+    return Status::Ok;
+  }
+
+  /**
+   * @brief Apply a batch of log entries segment by segment, in log order within a segment, see
+   * `replay_log`.
+   *
+   * @param entries The entries.
+   * @param n Number of entries.
+   * @param order Scratch space for the partition.
+   * @return The status of the first failed insertion, `Ok` if none fails.
+   */
+  auto replay_log_batch(const uint8_t *entries, const size_t n, std::vector<uint32_t> &order)
+      -> Status {
+    const auto full_hash_of = [entries](const size_t i) {
+      uint64_t full_hash;
+      memcpy(&full_hash, entries + i * LOG_ENTRY_SIZE, sizeof(full_hash));
+      return full_hash;
+    };
+
+    order.resize(n);
+    if (shrink_autonomously_) {
+      // A removal may merge two segments in the middle of the batch, after which entries of both
+      // must be applied in log order, so the batch is applied as logged
+      for (size_t i = 0; i < n; i++)
+        order[i] = i;
+    } else {
+      // Counting sort by the first lookup table slot of the segment, which is stable, so the
+      // entries of a segment keep their log order: a removal of an absent item is never applied
+      // after a later insertion of a colliding one. Expanding a segment in the middle of the
+      // batch splits its entries between the halves without reordering them
+      const auto segment_of = [&](const size_t i) {
+        return lookup_table[segment_index(full_hash_of(i) & LOWER_32_BIT_MASK)]->first_lut_slot;
+      };
+      std::vector<uint32_t> offsets(LOOKUP_TABLE_SIZE + 1, 0);
+      for (size_t i = 0; i < n; i++)
+        offsets[segment_of(i) + 1]++;
+      for (size_t slot = 0; slot < LOOKUP_TABLE_SIZE; slot++)
+        offsets[slot + 1] += offsets[slot];
+      for (size_t i = 0; i < n; i++)
+        order[offsets[segment_of(i)]++] = i;
+    }
+
+    Status res = Status::Ok;
+    for (const uint32_t i : order) {
+      const uint64_t full_hash = full_hash_of(i);
+      if (static_cast<LogOp>(entries[i * LOG_ENTRY_SIZE + sizeof(uint64_t)]) == LogOp::Remove) {
+        remove_hashed(full_hash);
+        continue;
+      }
+      const Status insert_res = insert_hashed(full_hash);
+      if (res == Status::Ok)
+        res = insert_res;
+    }
+    return res;
+  }
+
+#if defined(__unix__) || defined(__APPLE__)
+  /**
+   * @brief Write the header of a new log, or check the header of an existing one and drop a torn
+   * entry at its end, so that new entries are appended at an entry boundary.
+   *
+   * @param fd The log file, opened for appending.
+   * @return The status of the operation.
+   */
+  auto prepare_log(const int fd) const -> Status {
+    const uint64_t header[] = {LOG_MAGIC, FILE_VERSION, ENABLE_FINGERPRINT_GROWTH, k_hash_seed};
+    struct stat st{};
+    if (::fstat(fd, &st) != 0)
+      return Status::IOError;
+    const auto size = static_cast<size_t>(st.st_size);
+    if (size == 0)
+      return write_fully(fd, header, sizeof(header)) && sync_file(fd) ? Status::Ok
+                                                                     : Status::IOError;
+
+    uint64_t file_header[4];
+    if (size < sizeof(file_header) ||
+        ::pread(fd, file_header, sizeof(file_header), 0) != sizeof(file_header))
+      return Status::IOError;
+    if (const Status res = check_log_header(file_header); res != Status::Ok)
+      return res;
+    const size_t torn_bytes = (size - sizeof(file_header)) % LOG_ENTRY_SIZE;
+    if (torn_bytes != 0 && ::ftruncate(fd, static_cast<off_t>(size - torn_bytes)) != 0)
+      return Status::IOError;
+    return Status::Ok;
+  }
+
+  /**
+   * @brief Write a buffer to a file, retrying partial and interrupted writes.
+   *
+   * @param fd The file.
+   * @param data The buffer.
+   * @param size Size of the buffer in bytes.
+   * @return True if the whole buffer is written.
+   */
+  static auto write_fully(const int fd, const void *data, size_t size) -> bool {
+    const auto *bytes = static_cast<const uint8_t *>(data);
+    while (size > 0) {
+      const ssize_t written = ::write(fd, bytes, size);
+      if (written < 0 && errno == EINTR)
+        continue;
+      if (written <= 0)
+        return false;
+      bytes += written;
+      size -= static_cast<size_t>(written);
+    }
+    return true;
+  }
+
+  /**
+   * @brief Flush the data written to a file to its storage device.
+   *
+   * @param fd The file.
+   * @return True if the data is flushed.
+   */
+  static auto sync_file(const int fd) -> bool {
+#if defined(__APPLE__)
+    // macOS does not provide `fdatasync`
+    return ::fsync(fd) == 0;
+#else
+    return ::fdatasync(fd) == 0;
+#endif
+  }
+#endif
+
+  /**
+   * @brief Flush a file written through a stream (after closing it), or the entries of a
+   * directory, to the storage device. Does nothing on platforms without POSIX file I/O.
+   *
+   * @param path The file or directory.
+   * @return True if it is flushed.
+   */
+  static auto sync_path(const std::filesystem::path &path) -> bool {
+#if defined(__unix__) || defined(__APPLE__)
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      return false;
+    // A directory needs its metadata flushed too, so `fdatasync` is not enough
+    const bool res = ::fsync(fd) == 0;
+    ::close(fd);
+    return res;
+#else
+    return true;
+#endif
+  }
+
+  /**
+   * @brief Write the header shared by `save`, `checkpoint` and `export_tags`, followed by
+   * `expansion_times` unless exporting tags.
+   *
+   * @param os The stream to write to.
+   * @param magic `FILE_MAGIC`, `CHECKPOINT_MAGIC` or `TAGS_MAGIC`.
+   * @return True if the header is written.
+   */
+  auto write_header(std::ostream &os, const uint64_t magic) const -> bool {
+    static_assert(sizeof(size_t) == sizeof(uint64_t));
+    const uint64_t header[] = {magic,
+                               FILE_VERSION,
+                               ENABLE_FINGERPRINT_GROWTH,
+                               k_initial_bits_per_item,
+                               k_hash_seed,
+                               LOOKUP_TABLE_SIZE,
+                               INITIAL_SEG_COUNT,
+                               BUCKETS_PER_SEG,
+                               SLOTS_PER_BUCKET,
+                               Config::SEMI_SORTED_BUCKETS,
+                               Config::ALT_BLOCK_BUCKETS,
+                               num_seg};
+    return write_bytes(os, header, sizeof(header)) &&
+           (magic == TAGS_MAGIC ||
+            write_bytes(os, expansion_times, sizeof(size_t) * LOOKUP_TABLE_SIZE));
+  }
+
+  /**
+   * @brief Read a header written by `write_header` into an empty filter (see the private
+   * constructor), setting its initial bits per item, hash seed, number of segments and expansion
+   * times (unless importing tags).
+   *
+   * @param is The stream to read from.
+   * @param magic The expected magic.
+   * @param filter The filter to fill.
+   * @return The status of the operation.
+   */
+  static auto read_header(std::istream &is, const uint64_t magic, DFF &filter) -> Status {
+    uint64_t header[12];
+    if (!read_bytes(is, header, sizeof(header)))
+      return Status::IOError;
+    const auto [file_magic, version, fingerprint_growth, initial_bits_per_item, hash_seed,
+                lookup_table_size, initial_seg_count, buckets_per_seg, slots_per_bucket,
+                semi_sorted_buckets, alt_block_buckets, seg_count] = header;
+    if (file_magic != magic)
+      return Status::IOError;
+    if (version != FILE_VERSION || fingerprint_growth != ENABLE_FINGERPRINT_GROWTH ||
+        lookup_table_size != LOOKUP_TABLE_SIZE || initial_seg_count != INITIAL_SEG_COUNT ||
+        buckets_per_seg != BUCKETS_PER_SEG || slots_per_bucket != SLOTS_PER_BUCKET ||
+        alt_block_buckets != Config::ALT_BLOCK_BUCKETS)
+      return Status::NotSupported;
+    if (!SingleTable<ENABLE_FINGERPRINT_GROWTH, Config>::supports_bits_per_tag(
+            initial_bits_per_item))
+      return Status::NotSupported;
+    // Exported tags do not depend on the bucket encoding
+    if (magic != TAGS_MAGIC && semi_sorted_buckets != Config::SEMI_SORTED_BUCKETS)
+      return Status::NotSupported;
+    if (seg_count < INITIAL_SEG_COUNT || seg_count > LOOKUP_TABLE_SIZE)
+      return Status::IOError;
+
+    filter.k_initial_bits_per_item = initial_bits_per_item;
+    filter.k_hash_seed = hash_seed;
+    filter.num_seg = seg_count;
+    if (magic != TAGS_MAGIC &&
+        !read_bytes(is, filter.expansion_times, sizeof(size_t) * LOOKUP_TABLE_SIZE))
+      return Status::IOError;
+    return Status::Ok;
+  }
+
+  /**
+   * @brief Check that all lookup table slots of a filter filled by `read_header` and
+   * `assign_lookup_table_slots` are assigned, and calculate its `max_expansion`.
+   *
+   * @param filter The filter.
+   * @return True if the filter is complete.
+   */
+  static auto finish_loading(DFF &filter) -> bool {
+    if (std::find(filter.lookup_table, filter.lookup_table + LOOKUP_TABLE_SIZE, nullptr) !=
+        filter.lookup_table + LOOKUP_TABLE_SIZE)
+      return false;
+    for (size_t group = 0; group < INITIAL_SEG_COUNT; group++)
+      filter.max_expansion[group] = *std::max_element(
+          filter.expansion_times + group * INITIAL_LOOKUP_TABLE_ENTRIES_PER_SEG,
+          filter.expansion_times + (group + 1) * INITIAL_LOOKUP_TABLE_ENTRIES_PER_SEG);
+    return true;
+  }
+
+  /**
+   * @brief Replace this filter with a loaded one, keeping the runtime settings of this filter.
+   *
+   * @param filter The loaded filter, left with the old contents of this filter.
+   */
+  void adopt_loaded(DFF &filter) {
+    filter.shrink_autonomously_ = shrink_autonomously_;
+    filter.shrink_low_water_mark_ = shrink_low_water_mark_;
+    filter.load_threshold_ = load_threshold_;
+    filter.max_kick_rate_ = max_kick_rate_;
+    filter.apply_load_threshold();
+    filter.memory_budget_ = memory_budget_;
+    swap(filter);
+  }
+
+  /**
+   * @brief Implementation of `load` and `open_mmap`.
+   *
+   * @param is The stream to read from.
+   * @param mapped_base If not `nullptr`, the memory mapping `is` reads from, see `Segment::load`.
+   * It is owned by the filter on success.
+   * @param mapped_length Length of the memory mapping.
+   * @return The status of the operation.
+   */
+  auto load_impl(std::istream &is, uint8_t *mapped_base, const size_t mapped_length) -> Status {
+    DFF filter;
+    const Status res = read_header(is, FILE_MAGIC, filter);
+    if (res != Status::Ok)
+      return res;
+    for (size_t i = 0; i < filter.num_seg; i++) {
+      auto *seg = Segment<T, ENABLE_FINGERPRINT_GROWTH, Config>::load(
+          is, filter.k_initial_bits_per_item, mapped_base);
+      if (seg == nullptr)
+        return Status::IOError;
+      filter.append_segment(seg);
+      if (!filter.assign_lookup_table_slots(seg))
+        return Status::IOError;
+    }
+    if (!finish_loading(filter))
+      return Status::IOError;
+
+    filter.mapped_addr_ = mapped_base;
+    filter.mapped_length_ = mapped_length;
+    adopt_loaded(filter);
+    return Status::Ok;
+  }
+
+  [[nodiscard]] static auto checkpoint_manifest_path(const std::string &dir)
+      -> std::filesystem::path {
+    return std::filesystem::path(dir) / "manifest.bin";
+  }
+
+  [[nodiscard]] static auto checkpoint_segment_path(const std::string &dir, const uint64_t slot,
+                                                    const uint64_t epoch)
+      -> std::filesystem::path {
+    return std::filesystem::path(dir) /
+           ("segment_" + std::to_string(slot) + "_" + std::to_string(epoch) + ".bin");
+  }
+
+  /**
+   * @brief Create an empty segment, allocating its tag storage from the table arena if any.
+   *
+   * @param bits_per_item Bits per item of the segment.
+   * @return The segment, or `nullptr` if the table arena is exhausted.
+   */
+  auto new_segment(const size_t bits_per_item) -> Segment<T, ENABLE_FINGERPRINT_GROWTH, Config> * {
+    uint8_t *table_data = nullptr;
+    if (table_arena_ != nullptr) {
+      table_data =
+          table_arena_->allocate(SingleTable<ENABLE_FINGERPRINT_GROWTH, Config>::size_in_bytes(
+              BUCKETS_PER_SEG, bits_per_item));
+      if (table_data == nullptr)
+        return nullptr;
+    }
+    auto *seg = new Segment<T, ENABLE_FINGERPRINT_GROWTH, Config>(
+        BUCKETS_PER_SEG, bits_per_item, k_initial_bits_per_item, table_data);
+    seg->capacity = segment_capacity();
+    return seg;
+  }
+
+  /**
+   * @brief Get the capacity of a segment under the load threshold in effect, see
+   * `set_load_threshold` and `set_adaptive_expansion`.
+   *
+   * @return The capacity.
+   */
+  [[nodiscard]] auto segment_capacity() const -> size_t {
+    const double load_threshold = max_kick_rate_ != 0.0 ? MAX_LOAD_THRESHOLD : load_threshold_;
+    return static_cast<size_t>(static_cast<double>(BUCKETS_PER_SEG * SLOTS_PER_BUCKET) *
+                               load_threshold);
+  }
+
+  /**
+   * @brief Set the capacity of every segment after the load threshold in effect has changed.
+   */
+  void apply_load_threshold() {
+    const size_t capacity = segment_capacity();
+    for (auto *seg = head; seg != nullptr; seg = seg->next)
+      seg->capacity = capacity;
+  }
+
+  /**
+   * @brief Whether a segment should be expanded, see `Segment::needs_expansion` and
+   * `set_adaptive_expansion`.
+   *
+   * @param seg The segment.
+   * @return True if the segment should be expanded.
+   */
+  [[nodiscard]] auto should_expand(const Segment<T, ENABLE_FINGERPRINT_GROWTH, Config> *seg) const
+      -> bool {
+    return seg->needs_expansion() || (max_kick_rate_ != 0.0 && seg->kick_rate > max_kick_rate_);
+  }
+
+  /**
+   * @brief Append a segment to the end of the segment list.
+   *
+   * @param seg The segment to append.
+   */
+  void append_segment(Segment<T, ENABLE_FINGERPRINT_GROWTH, Config> *seg) {
+    if (head == nullptr)
+      head = seg;
+    else
+      tail->next = seg;
+    seg->prev = tail;
+    tail = seg;
+    memory_usage_ += segment_memory_usage(seg->k_bits_per_item);
+  }
+
+  /**
+   * @brief Point the lookup table slots of a loaded segment to it, after checking that they are
+   * laid out as `expand` would lay them out: a contiguous run of unassigned slots, aligned to its
+   * length (a power of 2), whose expansion times match the length.
+   *
+   * @param seg The segment.
+   * @return True if the slots are valid.
+   */
+  auto assign_lookup_table_slots(Segment<T, ENABLE_FINGERPRINT_GROWTH, Config> *seg) -> bool {
+    const uint32_t count = seg->lut_slots_count;
+    if (count == 0 || count > INITIAL_LOOKUP_TABLE_ENTRIES_PER_SEG || (count & (count - 1)) != 0 ||
+        seg->first_lut_slot % count != 0)
+      return false;
+    const auto expansion_time =
+        static_cast<size_t>(std::countr_zero(INITIAL_LOOKUP_TABLE_ENTRIES_PER_SEG / count));
+    for (uint32_t i = 0; i < count; i++) {
+      const uint32_t slot = seg->first_lut_slot + i;
+      if (slot >= LOOKUP_TABLE_SIZE || lookup_table[slot] != nullptr ||
+          expansion_times[slot] != expansion_time)
+        return false;
+      lookup_table[slot] = seg;
+    }
+    return true;
+  }
+
+  /**
+   * @brief Decide which of the two segments a tag belongs to when its segment is expanded.
+   *
+   * `should_remove` is usually true if `should_move` is true, but false when fingerprint length is
+   * exhausted, and in such case the tag will be kept in both segments.
+   *
+   * @param tag The tag in the segment being expanded.
+   * @param seg_bits_per_item Bits per item of the segment being expanded.
+   * @param expansion_time Expansion times of the segment being expanded.
+   * @param should_move Whether the tag should be written to the new segment.
+   * @param should_remove Whether the tag should be removed from the segment being expanded.
+   */
+  void split_tag(const uint32_t tag, const size_t seg_bits_per_item, const size_t expansion_time,
+                 bool &should_move, bool &should_remove) const {
+    if constexpr (ENABLE_FINGERPRINT_GROWTH) {
+      if (expansion_time >= seg_bits_per_item - __builtin_ctz(tag)) {
+        // spdlog::warn("Fingerprint length exhausted. tag: {}, expansion_time: {}", tag,
+        //              expansion_time);
+        should_remove = false;
+        should_move = true;
+      } else {
+        should_remove = should_move = ((tag >> (seg_bits_per_item - expansion_time)) & 1) == 1;
+      }
+    } else {
+      if (expansion_time + 1 >= k_initial_bits_per_item) {
+        should_remove = false;
+        should_move = true;
+      } else {
+        should_remove = should_move =
+            ((tag >> (k_initial_bits_per_item - 1 - expansion_time)) & 1) == 1;
+      }
+    }
+  }
+
+  /**
+   * @brief Insert a tag of another filter's segment into the segments of this filter covering the
+   * slots of that segment, see `merge_from`. If this filter is split further, the tag is split the
+   * way `expand` would split it, recursively, until it reaches a segment covering its slots.
+   *
+   * @param bucket The bucket index of the tag.
+   * @param tag The tag.
+   * @param tag_bits_per_item Bits per item of the segment the tag comes from.
+   * @param first_slot The first lookup table slot covered by the tag's segment.
+   * @param count The number of lookup table slots covered by the tag's segment.
+   * @return The status of the operation.
+   */
+  auto merge_tag(const size_t bucket, const uint32_t tag, const size_t tag_bits_per_item,
+                 const uint32_t first_slot, const uint32_t count) -> Status {
+    auto *seg = lookup_table[first_slot];
+    if (seg->lut_slots_count >= count) {
+      if (!should_expand(seg) || expand(first_slot, seg) != Status::Ok) {
+        seg = writable_segment(seg);
+        const Status res = seg->insert_foreign_tag(bucket, tag, tag_bits_per_item);
+        // Under a memory budget, the item is kept by saturating the segment, as in `insert`
+        if (res == Status::NotEnoughSpace && memory_budget_ != 0)
+          seg->num_lost++;
+        return res;
+      }
+      // Expanded, so the tag may belong to either half now
+      return merge_tag(bucket, tag, tag_bits_per_item, first_slot, count);
+    }
+
+    bool should_move;
+    bool should_remove;
+    const auto expansion_time =
+        static_cast<size_t>(std::countr_zero(INITIAL_LOOKUP_TABLE_ENTRIES_PER_SEG / count));
+    split_tag(tag, tag_bits_per_item, expansion_time, should_move, should_remove);
+    const uint32_t half = count / 2;
+    Status res = Status::Ok;
+    if (!should_remove)
+      res = merge_tag(bucket, tag, tag_bits_per_item, first_slot, half);
+    if (should_move) {
+      const Status move_res =
+          ENABLE_FINGERPRINT_GROWTH
+              ? merge_tag(bucket, tag << 1, tag_bits_per_item + 1, first_slot + half, half)
+              : merge_tag(bucket, tag, tag_bits_per_item, first_slot + half, half);
+      if (res == Status::Ok)
+        res = move_res;
+    }
+    return res;
+  }
+
+  /**
+   * @brief Find the sibling of a segment, i.e., the segment occupying the other half of the lookup
+   * table slots the two segments were split from by `expand`.
+   *
+   * @param seg The segment to find the sibling for.
+   * @return The sibling, or `nullptr` if `seg` is an initial segment or its sibling has been
+   * expanded again.
+   */
+  [[nodiscard]] auto sibling_of(const Segment<T, ENABLE_FINGERPRINT_GROWTH, Config> *seg) const
+      -> Segment<T, ENABLE_FINGERPRINT_GROWTH, Config> * {
+    const uint32_t count = seg->lut_slots_count;
+    if (count == 0 || count >= INITIAL_LOOKUP_TABLE_ENTRIES_PER_SEG)
+      return nullptr;
+    // Lookup table slots of a segment are contiguous and aligned to their count (a power of 2)
+    const uint32_t sibling_first_slot = seg->first_lut_slot ^ count;
+    auto *sibling = lookup_table[sibling_first_slot];
+    if (sibling->lut_slots_count != count || sibling->first_lut_slot != sibling_first_slot)
+      return nullptr;
+    return sibling;
+  }
+
+  [[nodiscard]] static auto
+  fits_in_one_segment(const Segment<T, ENABLE_FINGERPRINT_GROWTH, Config> *seg1,
+                      const Segment<T, ENABLE_FINGERPRINT_GROWTH, Config> *seg2,
+                      const double load_factor) -> bool {
+    return static_cast<double>(seg1->num_items + seg2->num_items) <=
+           load_factor * static_cast<double>(seg1->capacity);
+  }
+
+  /**
+   * @brief Fold the upper segment of a sibling pair into the lower one and hand its lookup table
+   * slots back. On success, the upper segment is left unmodified but without lookup table slots
+   * pointing to it (see `is_folded`), and should be deleted by `delete_folded_segments`.
    *
+   * @param lower The sibling with the lower lookup table slots (the one `expand` kept).
+   * @param upper The sibling with the upper lookup table slots (the one `expand` created).
    * @return The status of the operation.
    */
-  auto compact() -> Status {
-    // TODO: Implement this
+  auto fold_siblings(Segment<T, ENABLE_FINGERPRINT_GROWTH, Config> *lower,
+                     Segment<T, ENABLE_FINGERPRINT_GROWTH, Config> *upper) -> Status {
+    lower = writable_segment(lower);
+    const Status res = lower->absorb(*upper);
+    if (res != Status::Ok)
+      return res;
+
+    const uint32_t count = lower->lut_slots_count;
+    for (uint32_t i = 0; i < count; i++)
+      lookup_table[upper->first_lut_slot + i] = lower;
+    lower->lut_slots_count = count * 2;
+    for (uint32_t i = 0; i < lower->lut_slots_count; i++)
+      expansion_times[lower->first_lut_slot + i]--;
+
+    const size_t group = lower->first_lut_slot / INITIAL_LOOKUP_TABLE_ENTRIES_PER_SEG;
+    max_expansion[group] =
+        *std::max_element(expansion_times + group * INITIAL_LOOKUP_TABLE_ENTRIES_PER_SEG,
+                          expansion_times + (group + 1) * INITIAL_LOOKUP_TABLE_ENTRIES_PER_SEG);
+    num_seg--;
+
     return Status::Ok;
   }
+
+  /**
+   * @brief Whether a segment has been folded into its sibling by `fold_siblings`. The upper
+   * segment may be shared with a snapshot, so it is recognized by its first lookup table slot
+   * pointing to the lower segment instead of being modified.
+   *
+   * @param seg The segment.
+   * @return True if the segment is folded.
+   */
+  [[nodiscard]] auto is_folded(const Segment<T, ENABLE_FINGERPRINT_GROWTH, Config> *seg) const
+      -> bool {
+    return lookup_table[seg->first_lut_slot] != seg;
+  }
+
+  /**
+   * @brief Unlink and delete all segments folded by `fold_siblings`.
+   */
+  void delete_folded_segments() {
+    auto *current = head;
+    while (current != nullptr) {
+      auto *next = current->next;
+      if (is_folded(current)) {
+        unlink_segment(current);
+        memory_usage_ -= segment_memory_usage(current->k_bits_per_item);
+        release_segment(current);
+      }
+      current = next;
+    }
+  }
+
+  /**
+   * @brief Remove a segment from the segment list.
+   *
+   * @param seg The segment.
+   */
+  void unlink_segment(Segment<T, ENABLE_FINGERPRINT_GROWTH, Config> *seg) {
+    if (seg->prev == nullptr)
+      head = seg->next;
+    else
+      seg->prev->next = seg->next;
+    if (seg->next == nullptr)
+      tail = seg->prev;
+    else
+      seg->next->prev = seg->prev;
+  }
+
+  /**
+   * @brief Give up the ownership of a segment, deleting it if no snapshot shares it.
+   *
+   * @param seg The segment.
+   */
+  static void release_segment(Segment<T, ENABLE_FINGERPRINT_GROWTH, Config> *seg) {
+    // Reads of the segment by other owners happen before it is deleted
+    if (seg->ref_count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      delete seg;
+  }
+
+  /**
+   * @brief Get a segment that can be modified in place: the segment itself, or a private copy of
+   * it that replaces it in the segment list and the lookup table if a snapshot shares it
+   * (copy-on-write, see `snapshot`).
+   *
+   * @param seg The segment to be modified.
+   * @return The segment to modify instead.
+   */
+  auto writable_segment(Segment<T, ENABLE_FINGERPRINT_GROWTH, Config> *seg)
+      -> Segment<T, ENABLE_FINGERPRINT_GROWTH, Config> * {
+    if (seg->ref_count.load(std::memory_order_acquire) == 1)
+      return seg;
+
+    auto *copy = new Segment<T, ENABLE_FINGERPRINT_GROWTH, Config>(*seg);
+    copy->prev = seg->prev;
+    copy->next = seg->next;
+    if (copy->prev == nullptr)
+      head = copy;
+    else
+      copy->prev->next = copy;
+    if (copy->next == nullptr)
+      tail = copy;
+    else
+      copy->next->prev = copy;
+    for (uint32_t i = 0; i < copy->lut_slots_count; i++)
+      lookup_table[copy->first_lut_slot + i] = copy;
+    release_segment(seg);
+    return copy;
+  }
 };
 
+/**
+ * @brief An immutable point-in-time view of a filter, see `DFF::snapshot`. It answers queries and
+ * can be saved like the filter it was taken from.
+ */
+template <typename T, bool ENABLE_FINGERPRINT_GROWTH, typename Config,
+          bool BENCHMARK_TRACK_EXPANSION_TIME, bool BENCHMARK_TRACK_ADDRESSING_TIME>
+class DFF<T, ENABLE_FINGERPRINT_GROWTH, Config, BENCHMARK_TRACK_EXPANSION_TIME,
+          BENCHMARK_TRACK_ADDRESSING_TIME>::Snapshot {
+  // The lookup table and metadata of the filter at the time of the snapshot, without segments
+  DFF view_;
+  // The shared segments in list order
+  std::vector<Segment<T, ENABLE_FINGERPRINT_GROWTH, Config> *> segments_;
+
+  friend class DFF;
+
+  explicit Snapshot(const DFF &filter) {
+    view_.k_initial_bits_per_item = filter.k_initial_bits_per_item;
+    view_.k_hash_seed = filter.k_hash_seed;
+    view_.k_l_log = filter.k_l_log;
+    view_.num_seg = filter.num_seg;
+    std::copy(std::begin(filter.max_expansion), std::end(filter.max_expansion),
+              view_.max_expansion);
+    memcpy(view_.expansion_times, filter.expansion_times, sizeof(size_t) * LOOKUP_TABLE_SIZE);
+    memcpy(view_.lookup_table, filter.lookup_table,
+           sizeof(Segment<T, ENABLE_FINGERPRINT_GROWTH, Config> *) * LOOKUP_TABLE_SIZE);
+    segments_.reserve(filter.num_seg);
+    for (auto *seg = filter.head; seg != nullptr; seg = seg->next) {
+      seg->ref_count.fetch_add(1, std::memory_order_relaxed);
+      segments_.push_back(seg);
+    }
+  }
+
+public:
+  Snapshot(const Snapshot &) = delete;
+  Snapshot(Snapshot &&other) noexcept = default;
+  auto operator=(const Snapshot &) -> Snapshot & = delete;
+  auto operator=(Snapshot &&other) noexcept -> Snapshot & {
+    std::swap(view_, other.view_);
+    std::swap(segments_, other.segments_);
+    return *this;
+  }
+
+  ~Snapshot() {
+    for (auto *seg : segments_)
+      release_segment(seg);
+  }
+
+  /**
+   * @brief Query if an item was in the filter when the snapshot was taken, see `DFF::query`.
+   *
+   * @param item The item to query.
+   * @return The status of the operation.
+   */
+  auto query(const T &item) const -> Status {
+    uint32_t bucket_idx;
+    uint32_t hash;
+    view_.generate_bucket_index_and_hash(item, &bucket_idx, &hash);
+    return view_.lookup_table[view_.segment_index(hash)]->query(bucket_idx, hash);
+  }
+
+  /**
+   * @brief Write the filter as it was when the snapshot was taken to a stream, in the format of
+   * `DFF::save`, so it can be loaded with `DFF::load`.
+   *
+   * @param os The stream to write to, should be opened in binary mode.
+   * @return The status of the operation. `IOError` if writing fails.
+   */
+  auto save(std::ostream &os) const -> Status {
+    if (!view_.write_header(os, FILE_MAGIC))
+      return Status::IOError;
+    for (const auto *seg : segments_)
+      if (!seg->save(os))
+        return Status::IOError;
+    return Status::Ok;
+  }
+
+  /**
+   * @brief Write the filter as it was when the snapshot was taken to a file, see
+   * `save(std::ostream &)`.
+   *
+   * @param path The file to write to. It is overwritten if it exists.
+   * @return The status of the operation. `IOError` if the file cannot be written.
+   */
+  auto save(const std::string &path) const -> Status {
+    std::ofstream os(path, std::ios::binary | std::ios::trunc);
+    if (!os)
+      return Status::IOError;
+    const Status res = save(os);
+    os.close();
+    return res == Status::Ok && !os ? Status::IOError : res;
+  }
+
+  /**
+   * @brief Get the memory held only by the snapshot, i.e., by segments the filter has copied on
+   * write since the snapshot was taken. This is the memory given back by destroying the snapshot.
+   *
+   * @return The memory usage in bytes.
+   */
+  [[nodiscard]] auto exclusive_memory_usage() const -> size_t {
+    size_t usage = sizeof(Snapshot) +
+                   (sizeof(Segment<T, ENABLE_FINGERPRINT_GROWTH, Config> *) + sizeof(size_t)) *
+                       LOOKUP_TABLE_SIZE +
+                   sizeof(Segment<T, ENABLE_FINGERPRINT_GROWTH, Config> *) * segments_.capacity();
+    for (const auto *seg : segments_)
+      if (seg->ref_count.load(std::memory_order_acquire) == 1)
+        usage += segment_memory_usage(seg->k_bits_per_item);
+    return usage;
+  }
+};
+
+// Filters of the default geometry with 8, 12 and 16 bits per tag fixed at compile time
+template <typename T> using DFF8 = DFF<T, false, FixedTagConfig<8>>;
+template <typename T> using DFF12 = DFF<T, false, FixedTagConfig<12>>;
+template <typename T> using DFF16 = DFF<T, false, FixedTagConfig<16>>;
+// Filters of the default geometry with semi-sorted buckets
+template <typename T, bool ENABLE_FINGERPRINT_GROWTH = false>
+using SemiSortedDFF = DFF<T, ENABLE_FINGERPRINT_GROWTH, SemiSortedConfig>;
+// Filters of the default geometry with two-choice insertions
+template <typename T, bool ENABLE_FINGERPRINT_GROWTH = false>
+using TwoChoiceDFF = DFF<T, ENABLE_FINGERPRINT_GROWTH, TwoChoiceConfig>;
+
 } // namespace dff
@@ -0,0 +1,478 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "DFF.hpp"
+#include "predefine.hpp"
+#include "segment.hpp"
+#include "singletable.hpp"
+#include "utils/arena.hpp"
+
+namespace dff {
+
+/**
+ * @brief A DFF whose segments and lookup table live in a POSIX shared memory object, so that the
+ * processes on a host query a single copy of the filter instead of one copy each. One writer
+ * process creates the filter with `create` and inserts and removes items, while any number of
+ * reader processes map it with `open` and query it as it changes.
+ *
+ * The shared memory starts with a header (see `SharedHeader`): the configuration, the expansion
+ * state, the lookup table as segment numbers, and a descriptor of each segment locating its table
+ * by its offset in the shared memory, since the memory is mapped at different addresses in
+ * different processes. The tables follow, allocated by the writer's filter from a `FixedArena`, so
+ * segments are never merged (automatic shrinking and `compact` are not available).
+ *
+ * Readers and the writer synchronize with a sequence lock: the sequence number is odd while the
+ * writer modifies the filter, and a reader retries a query if the number is odd or has changed
+ * since the query started. Readers never block the writer and never see a half-done insertion or
+ * expansion. If the writer dies while modifying the filter, readers wait forever, so the filter
+ * should be created again. Each object must be used by a single thread.
+ */
+template <typename T, bool ENABLE_FINGERPRINT_GROWTH = false, typename Config = DefaultConfig>
+class SharedDFF {
+  using Filter = DFF<T, ENABLE_FINGERPRINT_GROWTH, Config>;
+  using Table = SingleTable<ENABLE_FINGERPRINT_GROWTH, Config>;
+
+  // The geometry, see `Config`
+  static constexpr size_t LOOKUP_TABLE_SIZE = Config::LOOKUP_TABLE_SIZE;
+  static constexpr size_t BUCKETS_PER_SEG = Config::BUCKETS_PER_SEG;
+  static constexpr size_t SLOTS_PER_BUCKET = Config::SLOTS_PER_BUCKET;
+  static constexpr size_t INITIAL_SEG_COUNT = Config::INITIAL_SEG_COUNT;
+  static constexpr size_t INITIAL_LOOKUP_TABLE_ENTRIES_PER_SEG =
+      Config::INITIAL_LOOKUP_TABLE_ENTRIES_PER_SEG;
+
+  // Identifies a filter created by `create` ("DFFSHM" in little-endian byte order)
+  static constexpr uint64_t SHARED_MAGIC = 0x00004D4853464644;
+  // Version of the layout of the shared memory, bumped on incompatible changes
+  static constexpr uint64_t SHARED_VERSION = 4;
+  // See `DFF::k_l_log`
+  static constexpr size_t L_LOG = std::countr_zero(INITIAL_LOOKUP_TABLE_ENTRIES_PER_SEG);
+
+  // A segment in the shared memory
+  struct SharedSegment {
+    // Offset of the table from the start of the shared memory
+    uint64_t table_offset;
+    uint32_t bits_per_item;
+    StashEntry stash[STASH_SIZE];
+    uint8_t stash_size;
+    uint8_t saturated;
+  };
+
+  // The start of the shared memory
+  struct SharedHeader {
+    // Written last by `create`, so that a filter being created cannot be opened
+    std::atomic<uint64_t> magic;
+    uint64_t version;
+    uint64_t fingerprint_growth;
+    uint64_t initial_bits_per_item;
+    uint64_t hash_seed;
+    uint64_t lookup_table_size;
+    uint64_t initial_seg_count;
+    uint64_t buckets_per_seg;
+    uint64_t slots_per_bucket;
+    uint64_t semi_sorted_buckets;
+    uint64_t alt_block_buckets;
+    // Size of the shared memory in bytes
+    uint64_t size;
+    // Odd while the writer modifies the filter
+    std::atomic<uint64_t> sequence;
+    uint64_t num_seg;
+    uint64_t max_expansion[INITIAL_SEG_COUNT];
+    // Segment number of each lookup table slot
+    uint32_t lookup_table[LOOKUP_TABLE_SIZE];
+    SharedSegment segments[LOOKUP_TABLE_SIZE];
+  };
+  // Only lock-free atomics work across processes
+  static_assert(std::atomic<uint64_t>::is_always_lock_free);
+  static_assert(sizeof(size_t) == sizeof(uint64_t));
+
+  // Offset of the tables from the start of the shared memory
+  static constexpr size_t TABLES_OFFSET = (sizeof(SharedHeader) + 63) & ~63UZ;
+
+  uint8_t *base_ = nullptr;
+  SharedHeader *header_ = nullptr;
+  size_t size_ = 0;
+  // Copied from the header, which does not change after `create`
+  uint64_t hash_seed_ = 0;
+  size_t initial_bits_per_item_ = 0;
+
+  /* Writer only */
+  std::optional<FixedArena> arena_;
+  Filter *filter_ = nullptr;
+  // Number of each segment of `filter_` in the shared memory
+  std::unordered_map<const Segment<T, ENABLE_FINGERPRINT_GROWTH, Config> *, uint32_t>
+      segment_numbers_;
+
+public:
+  SharedDFF() = default;
+  SharedDFF(const SharedDFF &) = delete;
+  SharedDFF(SharedDFF &&) = delete;
+  auto operator=(const SharedDFF &) -> SharedDFF & = delete;
+  auto operator=(SharedDFF &&) -> SharedDFF & = delete;
+
+  ~SharedDFF() { close(); }
+
+  /**
+   * @brief Get the smallest size of a shared memory object that holds a filter, i.e., the header
+   * and the initial segments. Each expansion needs room for one more segment of up to
+   * `SingleTable::size_in_bytes(BUCKETS_PER_SEG, bits_per_item)` bytes (more with fingerprint
+   * growth), holding about `0.9 * BUCKETS_PER_SEG * SLOTS_PER_BUCKET` items.
+   *
+   * @param initial_bits_per_item Bits per item of the initial segments.
+   * @return The size in bytes.
+   */
+  [[nodiscard]] static constexpr auto min_size(const size_t initial_bits_per_item) -> size_t {
+    const size_t table_size = Table::size_in_bytes(BUCKETS_PER_SEG, initial_bits_per_item);
+    return TABLES_OFFSET + INITIAL_SEG_COUNT * ((table_size + 63) & ~63UZ);
+  }
+
+  /**
+   * @brief Create a filter in a new shared memory object, and become its writer.
+   *
+   * @param name Name of the shared memory object, see `shm_open`.
+   * @param initial_bits_per_item Bits per item of the initial segments.
+   * @param size Size of the shared memory object in bytes, which bounds the number of segments
+   * (see `min_size`). Pages are only backed by memory once written to.
+   * @return The status of the operation. `NotSupported` on platforms without POSIX shared memory
+   * or if `Config` fixes other bits per tag, `NotEnoughSpace` if `size` is smaller than
+   * `min_size`, `IOError` if the object exists or cannot be created.
+   */
+  auto create(const std::string &name, const size_t initial_bits_per_item, const size_t size)
+      -> Status {
+#if defined(__unix__) || defined(__APPLE__)
+    if (!Table::supports_bits_per_tag(initial_bits_per_item))
+      return Status::NotSupported;
+    if (size < min_size(initial_bits_per_item))
+      return Status::NotEnoughSpace;
+    close();
+
+    const int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0)
+      return Status::IOError;
+    void *addr = MAP_FAILED;
+    if (::ftruncate(fd, static_cast<off_t>(size)) == 0)
+      addr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    // The mapping stays valid after the object is closed
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+      ::shm_unlink(name.c_str());
+      return Status::IOError;
+    }
+
+    base_ = static_cast<uint8_t *>(addr);
+    size_ = size;
+    header_ = new (addr) SharedHeader{};
+    arena_.emplace(base_ + TABLES_OFFSET, size - TABLES_OFFSET);
+    filter_ = new Filter(initial_bits_per_item, &*arena_);
+    hash_seed_ = filter_->k_hash_seed;
+    initial_bits_per_item_ = initial_bits_per_item;
+
+    header_->version = SHARED_VERSION;
+    header_->fingerprint_growth = ENABLE_FINGERPRINT_GROWTH;
+    header_->initial_bits_per_item = initial_bits_per_item;
+    header_->hash_seed = hash_seed_;
+    header_->lookup_table_size = LOOKUP_TABLE_SIZE;
+    header_->initial_seg_count = INITIAL_SEG_COUNT;
+    header_->buckets_per_seg = BUCKETS_PER_SEG;
+    header_->slots_per_bucket = SLOTS_PER_BUCKET;
+    header_->semi_sorted_buckets = Config::SEMI_SORTED_BUCKETS;
+    header_->alt_block_buckets = Config::ALT_BLOCK_BUCKETS;
+    header_->size = size;
+    for (const auto *seg = filter_->head; seg != nullptr; seg = seg->next)
+      publish_segment(seg);
+    publish_lookup_table(filter_->head);
+    header_->magic.store(SHARED_MAGIC, std::memory_order_release);
+    return Status::Ok;
+#else
+    return Status::NotSupported;
+#endif
+  }
+
+  /**
+   * @brief Map a filter created by `create` (possibly by another process) to query it.
+   *
+   * @param name Name of the shared memory object.
+   * @return The status of the operation. `NotSupported` on platforms without POSIX shared memory
+   * or if the filter was created with another layout version, fingerprint growth mode or
+   * geometry, `IOError` if the object does not exist, cannot be mapped or is not a filter.
+   */
+  auto open(const std::string &name) -> Status {
+#if defined(__unix__) || defined(__APPLE__)
+    close();
+
+    const int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+      return Status::IOError;
+    struct stat st{};
+    void *addr = MAP_FAILED;
+    if (::fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= TABLES_OFFSET)
+      addr = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED)
+      return Status::IOError;
+
+    const auto *header = static_cast<const SharedHeader *>(addr);
+    const auto size = static_cast<size_t>(st.st_size);
+    Status res = Status::Ok;
+    if (header->magic.load(std::memory_order_acquire) != SHARED_MAGIC || header->size != size)
+      res = Status::IOError;
+    else if (header->version != SHARED_VERSION ||
+             header->fingerprint_growth != ENABLE_FINGERPRINT_GROWTH ||
+             header->lookup_table_size != LOOKUP_TABLE_SIZE ||
+             header->initial_seg_count != INITIAL_SEG_COUNT ||
+             header->buckets_per_seg != BUCKETS_PER_SEG ||
+             header->slots_per_bucket != SLOTS_PER_BUCKET ||
+             header->semi_sorted_buckets != Config::SEMI_SORTED_BUCKETS ||
+             header->alt_block_buckets != Config::ALT_BLOCK_BUCKETS ||
+             !Table::supports_bits_per_tag(header->initial_bits_per_item))
+      res = Status::NotSupported;
+    if (res != Status::Ok) {
+      ::munmap(addr, size);
+      return res;
+    }
+
+    base_ = static_cast<uint8_t *>(addr);
+    header_ = static_cast<SharedHeader *>(addr);
+    size_ = size;
+    hash_seed_ = header->hash_seed;
+    initial_bits_per_item_ = header->initial_bits_per_item;
+    return Status::Ok;
+#else
+    return Status::NotSupported;
+#endif
+  }
+
+  /**
+   * @brief Unmap the filter. The shared memory object is kept, see `unlink`.
+   */
+  void close() {
+#if defined(__unix__) || defined(__APPLE__)
+    // Before the tables it borrows are unmapped
+    delete filter_;
+    filter_ = nullptr;
+    arena_.reset();
+    segment_numbers_.clear();
+    if (base_ != nullptr)
+      ::munmap(base_, size_);
+    base_ = nullptr;
+    header_ = nullptr;
+    size_ = 0;
+#endif
+  }
+
+  /**
+   * @brief Remove a shared memory object created by `create`. Processes that have mapped it keep
+   * using it, and its memory is freed once all of them have unmapped it.
+   *
+   * @param name Name of the shared memory object.
+   * @return The status of the operation. `NotSupported` on platforms without POSIX shared memory,
+   * `IOError` if the object cannot be removed.
+   */
+  static auto unlink(const std::string &name) -> Status {
+#if defined(__unix__) || defined(__APPLE__)
+    return ::shm_unlink(name.c_str()) == 0 ? Status::Ok : Status::IOError;
+#else
+    return Status::NotSupported;
+#endif
+  }
+
+  /**
+   * @brief Insert an item into the filter, see `DFF::insert`. Only the writer can insert.
+   *
+   * @param item The item to insert.
+   * @return The status of the operation. `NotSupported` if this is not the writer,
+   * `NotEnoughSpace` if the item does not fit and the shared memory has no room for a new segment.
+   */
+  auto insert(const T &item) -> Status {
+    if (filter_ == nullptr)
+      return Status::NotSupported;
+
+    const uint64_t full_hash = Filter::hash(item, hash_seed_);
+    auto *seg = segment_of(full_hash);
+    const size_t num_seg = filter_->num_seg;
+    begin_write();
+    const Status res = filter_->insert_hashed(full_hash);
+    publish_segment(seg);
+    // Inserting an item expands its segment at most once
+    if (filter_->num_seg != num_seg) {
+      publish_segment(filter_->tail);
+      publish_lookup_table(filter_->tail);
+    }
+    end_write();
+    return res;
+  }
+
+  /**
+   * @brief Remove an item from the filter, see `DFF::remove`. Only the writer can remove.
+   *
+   * @param item The item to remove.
+   * @return The status of the operation. `NotSupported` if this is not the writer.
+   */
+  auto remove(const T &item) -> Status {
+    if (filter_ == nullptr)
+      return Status::NotSupported;
+
+    const uint64_t full_hash = Filter::hash(item, hash_seed_);
+    auto *seg = segment_of(full_hash);
+    begin_write();
+    const Status res = filter_->remove_hashed(full_hash);
+    publish_segment(seg);
+    end_write();
+    return res;
+  }
+
+  /**
+   * @brief Query if an item is in the filter, with false positive rate. A reader waits for the
+   * writer to finish an ongoing insertion or removal.
+   *
+   * @param item The item to query.
+   * @return The status of the operation. `NotSupported` if no filter is created or opened.
+   */
+  auto query(const T &item) const -> Status {
+    if (filter_ != nullptr)
+      return filter_->query(item);
+    if (header_ == nullptr)
+      return Status::NotSupported;
+
+    uint32_t bucket_idx;
+    uint32_t hash;
+    Filter::split_hash(Filter::hash(item, hash_seed_), &bucket_idx, &hash);
+    while (true) {
+      const uint64_t sequence = header_->sequence.load(std::memory_order_acquire);
+      if (sequence % 2 != 0) {
+        std::this_thread::yield();
+        continue;
+      }
+      const Status res = query_unsynchronized(bucket_idx, hash);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (header_->sequence.load(std::memory_order_relaxed) == sequence)
+        return res;
+    }
+  }
+
+  /**
+   * @brief Get the number of segments in the filter.
+   *
+   * @return The number of segments, 0 if no filter is created or opened.
+   */
+  [[nodiscard]] auto num_seg() const -> size_t {
+    if (header_ == nullptr)
+      return 0;
+    return std::atomic_ref<uint64_t>(header_->num_seg).load(std::memory_order_relaxed);
+  }
+
+private:
+  /**
+   * @brief Find the segment of the writer's filter an item belongs to.
+   *
+   * @param full_hash The full hash of the item.
+   * @return The segment.
+   */
+  auto segment_of(const uint64_t full_hash) const
+      -> Segment<T, ENABLE_FINGERPRINT_GROWTH, Config> * {
+    uint32_t bucket_idx;
+    uint32_t hash;
+    Filter::split_hash(full_hash, &bucket_idx, &hash);
+    return filter_->lookup_table[filter_->segment_index(hash)];
+  }
+
+  void begin_write() {
+    header_->sequence.store(header_->sequence.load(std::memory_order_relaxed) + 1,
+                            std::memory_order_relaxed);
+    // Readers that see any of the following writes see the odd sequence number as well
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  void end_write() {
+    header_->sequence.store(header_->sequence.load(std::memory_order_relaxed) + 1,
+                            std::memory_order_release);
+  }
+
+  /**
+   * @brief Write the descriptor of a segment of the writer's filter to the shared memory,
+   * numbering the segment if it is new.
+   *
+   * @param seg The segment.
+   */
+  void publish_segment(const Segment<T, ENABLE_FINGERPRINT_GROWTH, Config> *seg) {
+    const auto [it, _] =
+        segment_numbers_.try_emplace(seg, static_cast<uint32_t>(segment_numbers_.size()));
+    SharedSegment &shared = header_->segments[it->second];
+    shared.table_offset = static_cast<uint64_t>(seg->table->data() - base_);
+    shared.bits_per_item = static_cast<uint32_t>(seg->k_bits_per_item);
+    const auto stash = seg->stash();
+    std::fill(std::copy(stash.begin(), stash.end(), shared.stash), std::end(shared.stash),
+              StashEntry{});
+    shared.stash_size = static_cast<uint8_t>(stash.size());
+    shared.saturated = seg->saturated();
+  }
+
+  /**
+   * @brief Write the lookup table slots of a segment of the writer's filter and the expansion
+   * state to the shared memory, after the segment is created.
+   *
+   * @param seg The segment, `head` to write the whole lookup table.
+   */
+  void publish_lookup_table(const Segment<T, ENABLE_FINGERPRINT_GROWTH, Config> *seg) {
+    for (; seg != nullptr; seg = seg->next) {
+      const uint32_t number = segment_numbers_.at(seg);
+      for (uint32_t i = 0; i < seg->lut_slots_count; i++)
+        header_->lookup_table[seg->first_lut_slot + i] = number;
+    }
+    std::copy(std::begin(filter_->max_expansion), std::end(filter_->max_expansion),
+              header_->max_expansion);
+    std::atomic_ref<uint64_t>(header_->num_seg).store(filter_->num_seg, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Query the shared memory without synchronizing with the writer. The shared memory may
+   * be modified concurrently, so everything read is checked to stay within it, and the result is
+   * only meaningful if the sequence number has not changed.
+   *
+   * @param bucket_idx The bucket index of the item.
+   * @param hash The hash of the item.
+   * @return The status of the operation.
+   */
+  auto query_unsynchronized(const uint32_t bucket_idx, const uint32_t hash) const -> Status {
+    size_t max_expansion[INITIAL_SEG_COUNT];
+    for (size_t group = 0; group < INITIAL_SEG_COUNT; group++)
+      max_expansion[group] = std::min<size_t>(header_->max_expansion[group], L_LOG);
+    const uint32_t number =
+        header_->lookup_table[Filter::segment_index(hash, max_expansion, L_LOG)];
+    if (number >= LOOKUP_TABLE_SIZE)
+      return Status::NotFound;
+
+    const SharedSegment &shared = header_->segments[number];
+    const size_t bits_per_item = shared.bits_per_item;
+    const size_t table_offset = shared.table_offset;
+    if (bits_per_item < initial_bits_per_item_ ||
+        bits_per_item > (ENABLE_FINGERPRINT_GROWTH ? 31 : 32) ||
+        !Table::supports_bits_per_tag(bits_per_item) || table_offset < TABLES_OFFSET ||
+        table_offset > size_ ||
+        Table::size_in_bytes(BUCKETS_PER_SEG, bits_per_item) > size_ - table_offset)
+      return Status::NotFound;
+
+    const Table table(BUCKETS_PER_SEG, bits_per_item, base_ + table_offset);
+    return Segment<T, ENABLE_FINGERPRINT_GROWTH, Config>::query_parts(
+        table, bits_per_item - initial_bits_per_item_ + 1, shared.saturated, shared.stash,
+        std::min<size_t>(shared.stash_size, STASH_SIZE), bucket_idx, hash);
+  }
+};
+
+} // namespace dff
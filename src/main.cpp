@@ -37,7 +37,8 @@ void random_gen(size_t n, uint64_t *store) {
   return status == Ok               ? "Ok"
          : status == NotFound       ? "NotFound"
          : status == NotEnoughSpace ? "NotEnoughSpace"
-                                    : "NotSupported";
+         : status == NotSupported   ? "NotSupported"
+                                    : "IOError";
 }
 
 auto main() -> int {
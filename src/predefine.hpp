@@ -1,23 +1,147 @@
 #pragma once
 
+#include <bit>
 #include <cstddef>
+#include <cstdint>
 
 namespace dff {
 
-// Must be a power of 2
-constexpr size_t LOOKUP_TABLE_SIZE = 4096UZ;
+// How a query looks for a tag in its two buckets, see `Segment::query`
+enum class QueryStrategy : std::uint8_t {
+  // Both buckets slot by slot, stopping at the first match
+  Interleaved,
+  // The primary bucket fully, then the alternative one only if the tag is not there, which skips
+  // computing and reading the alternative bucket for most positive queries
+  PrimaryFirst,
+  // All slots of both buckets compared without branches and the results combined, which avoids
+  // the mispredicted early exits of negative queries
+  Branchless,
+};
 
-constexpr size_t BUCKETS_PER_SEG_POWER = 12UZ;
-// Segments per bucket (**MUST BE A POWER OF 2**)
-constexpr size_t BUCKETS_PER_SEG = 1UZ << BUCKETS_PER_SEG_POWER;
-constexpr size_t SLOTS_PER_BUCKET = 4UZ;
+/**
+ * @brief Geometry of a filter, passed as a template parameter to `DFF`, `Segment` and
+ * `SingleTable`, so that filters with different geometries can live in the same program, each with
+ * its geometry folded at compile time.
+ *
+ * @tparam LUT_SIZE Number of lookup table slots (**MUST BE A POWER OF 2**).
+ * @tparam BUCKETS_POWER Log2 of the number of buckets per segment.
+ * @tparam SLOTS Number of slots per bucket.
+ * @tparam INITIAL_CAPACITY Number of slots of the initial segments together, which must be a power
+ * of 2 multiple of the slots of a segment.
+ * @tparam TAG_BITS Bits per tag fixed at compile time (8, 12, 16 or 32), or 0 to give it at runtime
+ * (see `DFF::DFF`). Tags of a fixed width are read and written as whole words instead of going
+ * through the generic bit packing, but the width cannot grow, so it is only available without
+ * fingerprint growth.
+ * @tparam SEMI_SORT Whether buckets are semi-sorted (see `SingleTable`), saving 1 bit per tag at
+ * the cost of decoding a bucket on every access. Needs 4 slots per bucket and the bits per tag
+ * given at runtime.
+ * @tparam ALT_BLOCK Number of buckets (**MUST BE A POWER OF 2**) of the aligned blocks the two
+ * buckets of a tag are confined to, or 0 for the whole segment. With 4 16-bit tags per bucket, 8
+ * buckets make a 64-byte cache line and 512 buckets a 4 KB page, so that a query touches a single
+ * line or page, at the cost of a lower load before segments are expanded.
+ * @tparam QUERY How queries look for a tag in its two buckets (see `QueryStrategy`). It does not
+ * change how tags are placed, so filters with different strategies share their files.
+ * @tparam TWO_CHOICE Whether an insertion puts the tag into the less loaded of its two buckets
+ * instead of the first one with a free slot, so that buckets fill evenly and fewer insertions kick
+ * tags at high load, at the cost of reading both buckets of most insertions. Tags are found in
+ * either bucket anyway, so filters with and without it share their files.
+ */
+template <size_t LUT_SIZE = 4096UZ, size_t BUCKETS_POWER = 12UZ, size_t SLOTS = 4UZ,
+          size_t INITIAL_CAPACITY = 1UZ << 16, size_t TAG_BITS = 0UZ, bool SEMI_SORT = false,
+          size_t ALT_BLOCK = 0UZ, QueryStrategy QUERY = QueryStrategy::Interleaved,
+          bool TWO_CHOICE = false>
+struct Config {
+  // Must be a power of 2
+  static constexpr size_t LOOKUP_TABLE_SIZE = LUT_SIZE;
 
-constexpr size_t INITIAL_FILTER_CAPACITY = 1UZ << 16;
-// Initial number of segments
-constexpr size_t INITIAL_SEG_COUNT = INITIAL_FILTER_CAPACITY / SLOTS_PER_BUCKET / BUCKETS_PER_SEG;
-// Initial number of lookup table entries per segment
-constexpr size_t INITIAL_LOOKUP_TABLE_ENTRIES_PER_SEG = LOOKUP_TABLE_SIZE / INITIAL_SEG_COUNT;
+  static constexpr size_t BUCKETS_PER_SEG_POWER = BUCKETS_POWER;
+  // Segments per bucket (**MUST BE A POWER OF 2**)
+  static constexpr size_t BUCKETS_PER_SEG = 1UZ << BUCKETS_PER_SEG_POWER;
+  static constexpr size_t SLOTS_PER_BUCKET = SLOTS;
 
-constexpr size_t TABLE_MASK = LOOKUP_TABLE_SIZE - 1;
+  static constexpr size_t INITIAL_FILTER_CAPACITY = INITIAL_CAPACITY;
+  // Initial number of segments
+  static constexpr size_t INITIAL_SEG_COUNT =
+      INITIAL_FILTER_CAPACITY / SLOTS_PER_BUCKET / BUCKETS_PER_SEG;
+  // Initial number of lookup table entries per segment
+  static constexpr size_t INITIAL_LOOKUP_TABLE_ENTRIES_PER_SEG =
+      LOOKUP_TABLE_SIZE / INITIAL_SEG_COUNT;
+
+  static constexpr size_t TABLE_MASK = LOOKUP_TABLE_SIZE - 1;
+
+  // 0 if the bits per tag are given at runtime
+  static constexpr size_t BITS_PER_TAG = TAG_BITS;
+  static constexpr bool SEMI_SORTED_BUCKETS = SEMI_SORT;
+  // 0 if the alternative bucket of a tag may be anywhere in the segment
+  static constexpr size_t ALT_BLOCK_BUCKETS = ALT_BLOCK;
+  static constexpr QueryStrategy QUERY_STRATEGY = QUERY;
+  static constexpr bool TWO_CHOICE_INSERT = TWO_CHOICE;
+
+  static_assert(std::has_single_bit(LOOKUP_TABLE_SIZE),
+                "The lookup table size must be a power of 2");
+  // Bucket indexes are 32-bit
+  static_assert(BUCKETS_PER_SEG_POWER < 32, "Too many buckets per segment");
+  // Slots are numbered with 8 bits, see `Segment::find_cuckoo_path`
+  static_assert(SLOTS_PER_BUCKET > 0 && SLOTS_PER_BUCKET < 256,
+                "The number of slots per bucket must be in [1, 255]");
+  static_assert(std::has_single_bit(INITIAL_SEG_COUNT) && INITIAL_SEG_COUNT <= LOOKUP_TABLE_SIZE,
+                "The initial number of segments must be a power of 2 not above the lookup table "
+                "size");
+  static_assert(BITS_PER_TAG == 0 || BITS_PER_TAG == 8 || BITS_PER_TAG == 12 ||
+                    BITS_PER_TAG == 16 || BITS_PER_TAG == 32,
+                "The fixed bits per tag must be 8, 12, 16 or 32");
+  static_assert(!SEMI_SORTED_BUCKETS || (SLOTS_PER_BUCKET == 4 && BITS_PER_TAG == 0),
+                "Semi-sorted buckets need 4 slots per bucket and the bits per tag given at "
+                "runtime");
+  // A block of 1 bucket would leave a single bucket per tag
+  static_assert(ALT_BLOCK_BUCKETS == 0 ||
+                    (std::has_single_bit(ALT_BLOCK_BUCKETS) && ALT_BLOCK_BUCKETS >= 2 &&
+                     ALT_BLOCK_BUCKETS <= BUCKETS_PER_SEG),
+                "The alternative bucket block must be a power of 2 in [2, BUCKETS_PER_SEG]");
+};
+
+// The geometry used unless another one is given
+using DefaultConfig = Config<>;
+
+// The default geometry with `BITS` bits per tag fixed at compile time
+template <size_t BITS>
+using FixedTagConfig =
+    Config<DefaultConfig::LOOKUP_TABLE_SIZE, DefaultConfig::BUCKETS_PER_SEG_POWER,
+           DefaultConfig::SLOTS_PER_BUCKET, DefaultConfig::INITIAL_FILTER_CAPACITY, BITS>;
+
+// The default geometry with semi-sorted buckets
+using SemiSortedConfig =
+    Config<DefaultConfig::LOOKUP_TABLE_SIZE, DefaultConfig::BUCKETS_PER_SEG_POWER,
+           DefaultConfig::SLOTS_PER_BUCKET, DefaultConfig::INITIAL_FILTER_CAPACITY, 0UZ, true>;
+
+// The default geometry with the two buckets of a tag in the same block of `BLOCK_BUCKETS` buckets
+template <size_t BLOCK_BUCKETS>
+using BlockedConfig = Config<DefaultConfig::LOOKUP_TABLE_SIZE, DefaultConfig::BUCKETS_PER_SEG_POWER,
+                             DefaultConfig::SLOTS_PER_BUCKET,
+                             DefaultConfig::INITIAL_FILTER_CAPACITY, 0UZ, false, BLOCK_BUCKETS>;
+
+// The default geometry with queries following `STRATEGY`
+template <QueryStrategy STRATEGY>
+using QueryConfig =
+    Config<DefaultConfig::LOOKUP_TABLE_SIZE, DefaultConfig::BUCKETS_PER_SEG_POWER,
+           DefaultConfig::SLOTS_PER_BUCKET, DefaultConfig::INITIAL_FILTER_CAPACITY, 0UZ, false, 0UZ,
+           STRATEGY>;
+
+// The default geometry with two-choice insertions
+using TwoChoiceConfig =
+    Config<DefaultConfig::LOOKUP_TABLE_SIZE, DefaultConfig::BUCKETS_PER_SEG_POWER,
+           DefaultConfig::SLOTS_PER_BUCKET, DefaultConfig::INITIAL_FILTER_CAPACITY, 0UZ, false, 0UZ,
+           QueryStrategy::Interleaved, true>;
+
+// Geometry of `DefaultConfig`
+constexpr size_t LOOKUP_TABLE_SIZE = DefaultConfig::LOOKUP_TABLE_SIZE;
+constexpr size_t BUCKETS_PER_SEG_POWER = DefaultConfig::BUCKETS_PER_SEG_POWER;
+constexpr size_t BUCKETS_PER_SEG = DefaultConfig::BUCKETS_PER_SEG;
+constexpr size_t SLOTS_PER_BUCKET = DefaultConfig::SLOTS_PER_BUCKET;
+constexpr size_t INITIAL_FILTER_CAPACITY = DefaultConfig::INITIAL_FILTER_CAPACITY;
+constexpr size_t INITIAL_SEG_COUNT = DefaultConfig::INITIAL_SEG_COUNT;
+constexpr size_t INITIAL_LOOKUP_TABLE_ENTRIES_PER_SEG =
+    DefaultConfig::INITIAL_LOOKUP_TABLE_ENTRIES_PER_SEG;
+constexpr size_t TABLE_MASK = DefaultConfig::TABLE_MASK;
 
 } // namespace dff
@@ -5,11 +5,20 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <span>
+#include <utility>
+#include <vector>
 
 #include "predefine.hpp"
 #include "singletable.hpp"
+#include "utils/io.hpp"
 
 namespace dff {
 
@@ -19,23 +28,50 @@ enum Status : std::uint8_t {
   NotFound = 1,
   NotEnoughSpace = 2,
   NotSupported = 3,
+  // Reading or writing a stream or file failed, or the data read is malformed
+  IOError = 4,
 };
 
-// Maximum number of cuckoo kicks before claiming failure
-constexpr size_t K_MAX_KICK_COUNT = 500;
+// Maximum number of tags moved by an insertion (the length of a cuckoo path) before claiming
+// failure
+constexpr size_t K_MAX_KICK_COUNT = 5;
+
+// Fraction of the slots of a segment that can be filled before it should be expanded, see
+// `Segment::capacity`
+constexpr double DEFAULT_LOAD_THRESHOLD = 0.9;
+
+// Number of tags a segment keeps outside its table when no cuckoo path is found
+constexpr size_t STASH_SIZE = 4;
+
+// A tag kept outside the table of a segment, see `Segment::insert_tag`
+struct StashEntry {
+  // The bucket the tag belongs to
+  uint32_t index;
+  uint32_t tag;
+};
 
 // A cuckoo filter class exposes a Bloomier filter interface,
 // providing methods of `insert`, `remove`, `query`. It takes three
 // template parameters:
 //   T: the type of item you want to insert
 //   ENABLE_FINGERPRINT_GROWTH: whether to enable fingerprint growth
-template <typename T, bool ENABLE_FINGERPRINT_GROWTH> class Segment {
-  static constexpr uint64_t HASH_SEED = 1234;
+//   Config: the geometry, see `Config`
+template <typename T, bool ENABLE_FINGERPRINT_GROWTH, typename Config = DefaultConfig>
+class Segment {
+public:
+  using Table = SingleTable<ENABLE_FINGERPRINT_GROWTH, Config>;
+
+private:
+  static constexpr size_t LOOKUP_TABLE_SIZE = Config::LOOKUP_TABLE_SIZE;
+  static constexpr size_t BUCKETS_PER_SEG = Config::BUCKETS_PER_SEG;
+  static constexpr size_t SLOTS_PER_BUCKET = Config::SLOTS_PER_BUCKET;
+  static constexpr size_t ALT_BLOCK_BUCKETS = Config::ALT_BLOCK_BUCKETS;
+  static constexpr QueryStrategy QUERY_STRATEGY = Config::QUERY_STRATEGY;
+  static constexpr bool TWO_CHOICE_INSERT = Config::TWO_CHOICE_INSERT;
 
-  // Evicted tag due to maximum number of kicks
-  bool victim_used_ = false;
-  size_t victim_index_ = 0;
-  uint32_t victim_tag_ = 0;
+  // Tags for which no cuckoo path was found, see `insert_tag`
+  StashEntry stash_[STASH_SIZE]{};
+  uint32_t stash_size_ = 0;
 
   /**
    * @brief Generate the bucket index for a given hash.
@@ -43,28 +79,234 @@ template <typename T, bool ENABLE_FINGERPRINT_GROWTH> class Segment {
    * @param hash The hash to generate the index for.
    * @return The index.
    */
-  [[nodiscard]] auto index_hash(uint32_t hash) const -> size_t {
+  [[nodiscard]] static auto index_hash(uint32_t hash) -> size_t {
     // NOTE: Assume that BUCKETS_PER_SEG is a power of 2
     return hash & (BUCKETS_PER_SEG - 1);
   }
 
+public:
   /**
    * @brief Generate an alternative index for a given index.
    *
    * @param index The index to generate an alternative index for.
    * @param tag The tag to use in the alternative index.
+   * @param bits_to_shift_used_by_alt_index See `k_bits_to_shift_used_by_alt_index`.
    * @return The alternative index.
    */
-  [[nodiscard]] auto alt_index(const size_t index, const uint32_t tag) const -> size_t {
+  [[nodiscard]] static auto alt_index(const size_t index, const uint32_t tag,
+                                      const size_t bits_to_shift_used_by_alt_index) -> size_t {
+    if constexpr (ALT_BLOCK_BUCKETS != 0) {
+      // Flip a nonzero offset within the block of the index, so that the two buckets differ and
+      // stay in the same block
+      const uint32_t mixed =
+          (ENABLE_FINGERPRINT_GROWTH ? tag >> bits_to_shift_used_by_alt_index : tag) * 0x5bd1e995;
+      return index ^ (1 + mixed % (ALT_BLOCK_BUCKETS - 1));
+    }
     // A quick and dirty way to generate an alternative index
     // 0x5bd1e995 is the hash constant from MurmurHash2
     if constexpr (ENABLE_FINGERPRINT_GROWTH)
       return index_hash(static_cast<uint32_t>(index) ^
-                        ((tag >> k_bits_to_shift_used_by_alt_index) * 0x5bd1e995));
+                        ((tag >> bits_to_shift_used_by_alt_index) * 0x5bd1e995));
     else
       return index_hash(static_cast<uint32_t>(index) ^ (tag * 0x5bd1e995));
   }
 
+private:
+  [[nodiscard]] auto alt_index(const size_t index, const uint32_t tag) const -> size_t {
+    return alt_index(index, tag, k_bits_to_shift_used_by_alt_index);
+  }
+
+  // A bucket reached by the search for a cuckoo path, see `find_cuckoo_path`
+  struct PathNode {
+    uint32_t bucket;
+    // The node whose tag moves into this bucket, or -1 for the two buckets of the inserted tag
+    int16_t parent;
+    // The slot of that tag in the parent bucket
+    uint8_t parent_slot;
+    // Number of tags moved to reach this bucket
+    uint8_t depth;
+  };
+
+  // Number of buckets the search for a cuckoo path visits at most: the two buckets of the inserted
+  // tag and every bucket reachable from them by moving fewer than `K_MAX_KICK_COUNT` tags. With
+  // large buckets, the deepest level is cut short to keep the nodes on the stack
+  static constexpr size_t MAX_PATH_NODES = [] {
+    size_t count = 0;
+    for (size_t depth = 0, width = 2; depth < K_MAX_KICK_COUNT; depth++, width *= SLOTS_PER_BUCKET)
+      count += width;
+    return std::min<size_t>(count, 4096);
+  }();
+
+  /**
+   * @brief Whether a bucket is on the path from the inserted tag to a node, in which case moving a
+   * tag into it would break the path.
+   *
+   * @param nodes The nodes visited by the search.
+   * @param node The index of the last node of the path.
+   * @param bucket The bucket index.
+   * @return True if the bucket is on the path.
+   */
+  [[nodiscard]] static auto on_cuckoo_path(const PathNode *nodes, int16_t node, const size_t bucket)
+      -> bool {
+    for (; node >= 0; node = nodes[node].parent)
+      if (nodes[node].bucket == bucket)
+        return true;
+    return false;
+  }
+
+  /**
+   * @brief Search breadth-first for the shortest cuckoo path making room for a tag whose two
+   * buckets are full: a chain of tags, each moving to its alternative bucket into the slot freed by
+   * the next one, the last one into an empty slot. Nothing is modified, so a failed search costs
+   * no writes.
+   *
+   * @param index1 The first bucket of the tag.
+   * @param index2 The second bucket of the tag.
+   * @param nodes Storage for the nodes visited, `MAX_PATH_NODES` of them.
+   * @param leaf The index of the node holding the last tag of the path.
+   * @param leaf_slot The slot of the last tag in its bucket.
+   * @param empty_index The bucket the last tag moves to.
+   * @param empty_slot The empty slot the last tag moves to.
+   * @return True if a path of at most `K_MAX_KICK_COUNT` tags is found.
+   */
+  auto find_cuckoo_path(const size_t index1, const size_t index2, PathNode *nodes, int16_t &leaf,
+                        size_t &leaf_slot, size_t &empty_index, size_t &empty_slot) const -> bool {
+    size_t num_nodes = 0;
+    nodes[num_nodes++] = {static_cast<uint32_t>(index1), -1, 0, 0};
+    if (index2 != index1)
+      nodes[num_nodes++] = {static_cast<uint32_t>(index2), -1, 0, 0};
+
+    for (size_t head = 0; head < num_nodes; head++) {
+      const PathNode node = nodes[head];
+      for (size_t slot = 0; slot < SLOTS_PER_BUCKET; slot++) {
+        const size_t next = alt_index(node.bucket, table->read_tag(node.bucket, slot));
+        if (next == node.bucket)
+          continue;
+        const size_t free_slot = table->find_empty_slot(next);
+        if (free_slot != SLOTS_PER_BUCKET) {
+          leaf = static_cast<int16_t>(head);
+          leaf_slot = slot;
+          empty_index = next;
+          empty_slot = free_slot;
+          return true;
+        }
+        if (static_cast<size_t>(node.depth) + 1 < K_MAX_KICK_COUNT && num_nodes < MAX_PATH_NODES &&
+            !on_cuckoo_path(nodes, static_cast<int16_t>(head), next))
+          nodes[num_nodes++] = {static_cast<uint32_t>(next), static_cast<int16_t>(head),
+                                static_cast<uint8_t>(slot), static_cast<uint8_t>(node.depth + 1)};
+      }
+    }
+    return false;
+  }
+
+  /**
+   * @brief Find a stashed tag that belongs to one of the two buckets and matches the hash. With
+   * fingerprint growth enabled, a stashed tag may have been moved from a segment with shorter tags,
+   * so it cannot be compared with the generated tag directly.
+   *
+   * @param table The table of the segment.
+   * @param stash The stash of the segment.
+   * @param stash_size Number of tags in the stash.
+   * @param index1 The first bucket index.
+   * @param index2 The second bucket index.
+   * @param hash The hash to match.
+   * @return The position of the tag in the stash, or `STASH_SIZE` if no tag matches.
+   */
+  [[nodiscard]] static auto find_in_stash(const Table &table, const StashEntry *stash,
+                                          const size_t stash_size, const size_t index1,
+                                          const size_t index2, const uint32_t hash) -> size_t {
+    for (size_t i = 0; i < stash_size; i++)
+      if ((stash[i].index == index1 || stash[i].index == index2) &&
+          table.matches_tag(hash, stash[i].tag))
+        return i;
+    return STASH_SIZE;
+  }
+
+  /**
+   * @brief Find if a bucket holds a tag that matches the hash, see `QueryStrategy::PrimaryFirst`.
+   *
+   * @param table The table of the segment.
+   * @param index The bucket index.
+   * @param hash The hash to match.
+   * @param tag The tag generated from the hash.
+   * @return True if a tag of the bucket matches the hash.
+   */
+  [[nodiscard]] static auto find_in_bucket(const Table &table, const size_t index,
+                                           const uint32_t hash, const uint32_t tag) -> bool {
+    if constexpr (ENABLE_FINGERPRINT_GROWTH)
+      return table.match_hash_in_bucket(index, hash);
+    else
+      return table.find_tag_in_bucket(index, tag);
+  }
+
+  /**
+   * @brief Put a tag into a free slot of one of its two buckets without moving other tags: the
+   * first bucket with one, or the less loaded one (the preferred one on a tie) with
+   * `Config::TWO_CHOICE_INSERT`.
+   *
+   * @param index The preferred index to insert the tag at.
+   * @param tag The tag to insert.
+   * @return True if the tag is inserted, false if both buckets are full.
+   */
+  auto place_tag(const size_t index, const uint32_t tag) -> bool {
+    if constexpr (TWO_CHOICE_INSERT) {
+      // An empty preferred bucket wins without reading the other one
+      const size_t count1 = table->count_tags_in_bucket(index);
+      if (count1 == 0)
+        return table->insert_tag_to_bucket(index, tag);
+      const size_t index2 = alt_index(index, tag);
+      const size_t count2 = table->count_tags_in_bucket(index2);
+      if (std::min(count1, count2) == SLOTS_PER_BUCKET)
+        return false;
+      return table->insert_tag_to_bucket(count2 < count1 ? index2 : index, tag);
+    } else {
+      return table->insert_tag_to_bucket(index, tag) ||
+             table->insert_tag_to_bucket(alt_index(index, tag), tag);
+    }
+  }
+
+  /**
+   * @brief Whether a stash read from a stream is well-formed.
+   *
+   * @param stash The stash.
+   * @param stash_size Number of tags in the stash.
+   * @return True if the stash is well-formed.
+   */
+  [[nodiscard]] static auto valid_stash(const StashEntry *stash, const uint64_t stash_size)
+      -> bool {
+    if (stash_size > STASH_SIZE)
+      return false;
+    for (size_t i = 0; i < stash_size; i++)
+      if (stash[i].index >= BUCKETS_PER_SEG || stash[i].tag == 0)
+        return false;
+    return true;
+  }
+
+  /**
+   * @brief Convert a tag of a segment with `from_bits_per_item` bits per item to a tag of this
+   * segment. With fingerprint growth enabled, the fingerprint is truncated if it is longer than
+   * this segment can hold, otherwise the tag is returned as is.
+   *
+   * @param tag The tag to convert.
+   * @param from_bits_per_item Bits per item of the segment the tag comes from.
+   * @return The converted tag.
+   */
+  [[nodiscard]] auto trim_tag(const uint32_t tag, const size_t from_bits_per_item) const
+      -> uint32_t {
+    if constexpr (ENABLE_FINGERPRINT_GROWTH) {
+      if (from_bits_per_item <= k_bits_per_item)
+        return tag << (k_bits_per_item - from_bits_per_item);
+      const size_t diff = from_bits_per_item - k_bits_per_item;
+      // Enough trailing zeros to shift out, the fingerprint itself is kept
+      if (static_cast<size_t>(__builtin_ctz(tag)) >= diff)
+        return tag >> diff;
+      // Drop the lowest fingerprint bits and append the unary mask again
+      return ((tag >> (diff + 1)) << 1) | 1;
+    } else {
+      return tag;
+    }
+  }
+
 public:
   size_t k_bits_per_item;
   // Used only when fingerprint growth is enabled
@@ -74,93 +316,227 @@ public:
 
   // Number of items stored
   size_t num_items = 0;
-  SingleTable<ENABLE_FINGERPRINT_GROWTH> *table;
-  Segment<T, ENABLE_FINGERPRINT_GROWTH> *next;
-
+  // Number of tags moved by insertions to make room for other tags, see `insert_tag`
+  uint64_t num_kicks = 0;
+  // Moving average of the tags moved per insertion, only tracked by `DFF` with adaptive expansion
+  // (see `DFF::set_adaptive_expansion`)
+  double kick_rate = 0.0;
+  // Number of items lost because the segment was full under a memory budget (see
+  // `DFF::set_memory_budget`). While there are any, the segment is saturated: it answers every
+  // query positively, until as many removals have not found their item (see `remove`).
+  uint64_t num_lost = 0;
+  // Whether the segment has been modified since it was last written by `DFF::checkpoint`
+  bool dirty = true;
+  // The checkpoint in which the segment was last written, see `DFF::checkpoint`
+  uint64_t checkpoint_epoch = 0;
+  // Number of owners of the segment: the filter and the snapshots sharing it, see `DFF::snapshot`
+  std::atomic<uint32_t> ref_count = 1;
+  Table *table;
+  Segment<T, ENABLE_FINGERPRINT_GROWTH, Config> *next;
+  Segment<T, ENABLE_FINGERPRINT_GROWTH, Config> *prev;
+
+  // Number of items beyond which the segment should be expanded, see `needs_expansion`
   size_t capacity;
 
-  // Corresponding lookup table slots occupied by this segment
-  uint32_t lut_slots[LOOKUP_TABLE_SIZE]{};
+  // First of the lookup table slots occupied by this segment, which are contiguous (see
+  // `DFF::assign_lookup_table_slots`)
+  uint32_t first_lut_slot = 0;
   // Number of lookup table slots occupied by this segment
   uint32_t lut_slots_count = 0;
 
-  Segment(const Segment &) = default;
-  Segment(Segment &&) = default;
-  auto operator=(const Segment &) -> Segment & = default;
-  auto operator=(Segment &&) -> Segment & = default;
+  // Deep copy, the copy is not linked to any other segment
+  Segment(const Segment &other)
+      : stash_size_(other.stash_size_), k_bits_per_item(other.k_bits_per_item),
+        k_high_bits_used_by_alt_index(other.k_high_bits_used_by_alt_index),
+        k_bits_to_shift_used_by_alt_index(other.k_bits_to_shift_used_by_alt_index),
+        num_items(other.num_items), num_kicks(other.num_kicks), kick_rate(other.kick_rate),
+        num_lost(other.num_lost), dirty(other.dirty), checkpoint_epoch(other.checkpoint_epoch),
+        table(new Table(*other.table)), next(nullptr), prev(nullptr), capacity(other.capacity),
+        first_lut_slot(other.first_lut_slot), lut_slots_count(other.lut_slots_count) {
+    memcpy(stash_, other.stash_, sizeof(stash_));
+  }
+  Segment(Segment &&other) noexcept
+      : stash_size_(other.stash_size_), k_bits_per_item(other.k_bits_per_item),
+        k_high_bits_used_by_alt_index(other.k_high_bits_used_by_alt_index),
+        k_bits_to_shift_used_by_alt_index(other.k_bits_to_shift_used_by_alt_index),
+        num_items(other.num_items), num_kicks(other.num_kicks), kick_rate(other.kick_rate),
+        num_lost(other.num_lost), dirty(other.dirty), checkpoint_epoch(other.checkpoint_epoch),
+        table(std::exchange(other.table, nullptr)), next(std::exchange(other.next, nullptr)),
+        prev(std::exchange(other.prev, nullptr)), capacity(other.capacity),
+        first_lut_slot(other.first_lut_slot), lut_slots_count(other.lut_slots_count) {
+    memcpy(stash_, other.stash_, sizeof(stash_));
+  }
+  auto operator=(const Segment &) -> Segment & = delete;
+  auto operator=(Segment &&) -> Segment & = delete;
 
+  /**
+   * @brief Create a new segment.
+   *
+   * @param num_buckets Bucket count.
+   * @param bits_per_item Bits per item.
+   * @param high_bits_used_by_alt_index High bits of the tag used by the alternative index (only
+   * used when fingerprint growth is enabled).
+   * @param table_data Borrowed tag storage for the table (see `SingleTable`), or `nullptr` to
+   * allocate an empty one.
+   */
   explicit Segment(const size_t num_buckets, const size_t bits_per_item,
-                   const size_t high_bits_used_by_alt_index)
+                   const size_t high_bits_used_by_alt_index, uint8_t *table_data = nullptr)
       : k_bits_per_item(bits_per_item), k_high_bits_used_by_alt_index(high_bits_used_by_alt_index),
         k_bits_to_shift_used_by_alt_index(k_bits_per_item - high_bits_used_by_alt_index + 1),
-        table(new SingleTable<ENABLE_FINGERPRINT_GROWTH>(num_buckets, bits_per_item)),
-        next(nullptr),
-        capacity(static_cast<size_t>(static_cast<double>(num_buckets) * SLOTS_PER_BUCKET * 0.9)) {}
+        table(table_data == nullptr ? new Table(num_buckets, bits_per_item)
+                                    : new Table(num_buckets, bits_per_item, table_data)),
+        next(nullptr), prev(nullptr),
+        capacity(static_cast<size_t>(static_cast<double>(num_buckets) * SLOTS_PER_BUCKET *
+                                     DEFAULT_LOAD_THRESHOLD)) {}
 
   ~Segment() { delete table; }
 
   /**
-   * @brief Try to insert a hash into a bucket at a given index. If the bucket
-   * is full, try another bucket with an alternative index and enable kickout,
-   * and repeat until a bucket is found or the maximum number of cuckoo kicks is
-   * reached.
-   *
-   * Warning: If this does not return `Ok`, you should stop inserting items anymore, otherwise
-   * some inserted items may be lost, causing false negatives.
+   * @brief Try to insert a hash into a bucket at a given index. If the bucket is full, try the
+   * bucket at the alternative index, and if both are full, move tags along the shortest cuckoo
+   * path of at most `K_MAX_KICK_COUNT` tags to make room (see `find_cuckoo_path`). If there is no
+   * such path, the tag is kept in the stash, and only once the stash is full is the insertion a
+   * failure, in which case nothing is modified (see `num_lost` for keeping the item anyway). A
+   * saturated segment does not store the tag, it counts the item as lost instead.
    *
    * @param index The preferred index to insert the tag at.
    * @param hash The hash to insert.
    * @return The status of the operation.
    */
   auto insert(const size_t &index, const uint32_t &hash) -> Status {
-    size_t cur_index = index;
-    uint32_t cur_tag = table->gen_tag(hash);
-    uint32_t old_tag;
+    // No need to kick, a saturated segment matches the item anyway, so it is counted as lost
+    if (saturated()) {
+      num_lost++;
+      dirty = true;
+      return Ok;
+    }
+    return insert_tag(index, table->gen_tag(hash));
+  }
+
+  /**
+   * @brief Same as `insert`, but takes an already generated tag instead of a hash.
+   *
+   * @param index The preferred index to insert the tag at.
+   * @param tag The tag to insert.
+   * @return The status of the operation.
+   */
+  auto insert_tag(const size_t &index, const uint32_t &tag) -> Status {
+    dirty = true;
 
-    if (table->insert_tag_to_bucket(cur_index, cur_tag, false, old_tag)) {
+    if (place_tag(index, tag)) {
       num_items++;
       return Ok;
     }
-    cur_index = alt_index(cur_index, cur_tag);
+    const size_t index2 = alt_index(index, tag);
 
-    for (size_t count = 0; count < K_MAX_KICK_COUNT; count++) {
-      old_tag = 0;
-      if (table->insert_tag_to_bucket(cur_index, cur_tag, true, old_tag)) {
-        num_items++;
-        return Ok;
+    PathNode nodes[MAX_PATH_NODES];
+    int16_t node;
+    size_t slot;
+    size_t to_index;
+    size_t to_slot;
+    if (find_cuckoo_path(index, index2, nodes, node, slot, to_index, to_slot)) {
+      // Move the tags from the end of the path, so that every tag moves into a free slot
+      while (true) {
+        const size_t from_index = nodes[node].bucket;
+        table->write_tag(to_index, to_slot, table->read_tag(from_index, slot));
+        num_kicks++;
+        to_index = from_index;
+        to_slot = slot;
+        if (nodes[node].parent < 0)
+          break;
+        slot = nodes[node].parent_slot;
+        node = nodes[node].parent;
       }
-      cur_tag = old_tag;
-      cur_index = alt_index(cur_index, cur_tag);
+      table->write_tag(to_index, to_slot, tag);
+      num_items++;
+      return Ok;
     }
 
-    victim_used_ = true;
-    victim_index_ = cur_index;
-    victim_tag_ = cur_tag;
-
+    if (stash_size_ < STASH_SIZE) {
+      stash_[stash_size_++] = {static_cast<uint32_t>(index), tag};
+      return Ok;
+    }
+    // Nothing has been moved, the caller decides whether the item is lost (see `num_lost`)
     return NotEnoughSpace;
   }
 
+  /**
+   * @brief Same as `insert_tag`, but takes a tag of a segment with `from_bits_per_item` bits per
+   * item, e.g., of another filter (see `DFF::merge_from`).
+   *
+   * @param index The preferred index to insert the tag at.
+   * @param tag The tag to insert.
+   * @param from_bits_per_item Bits per item of the segment the tag comes from.
+   * @return The status of the operation.
+   */
+  auto insert_foreign_tag(const size_t index, const uint32_t tag, const size_t from_bits_per_item)
+      -> Status {
+    return insert_tag(index, trim_tag(tag, from_bits_per_item));
+  }
+
   /**
    * @brief Query if a hash is in the filter at a given index, with false
-   * positive rate.
+   * positive rate. The buckets are searched as `Config::QUERY_STRATEGY` says.
    *
    * @param index The index to query.
    * @param tag The hash to query.
    * @return The status of the operation.
    */
   [[nodiscard]] auto query(const size_t &index, const uint32_t &hash) const -> Status {
-    const uint32_t tag = table->gen_tag(hash);
-    const size_t index2 = alt_index(index, tag);
+    return query_parts(*table, k_bits_to_shift_used_by_alt_index, saturated(), stash_, stash_size_,
+                       index, hash);
+  }
 
-    if (victim_used_ && (victim_index_ == index || victim_index_ == index2) && victim_tag_ == tag)
+  /**
+   * @brief Same as `query`, but on the parts of a segment instead of a segment object, so that a
+   * segment laid out elsewhere (e.g., in shared memory, see `SharedDFF`) can be queried in place.
+   *
+   * @param table The table of the segment.
+   * @param bits_to_shift_used_by_alt_index See `k_bits_to_shift_used_by_alt_index`.
+   * @param saturated Whether the segment is saturated.
+   * @param stash The stash of the segment.
+   * @param stash_size Number of tags in the stash.
+   * @param index The index to query the hash at.
+   * @param hash The hash to query.
+   * @return The status of the operation.
+   */
+  [[nodiscard]] static auto query_parts(const Table &table,
+                                        const size_t bits_to_shift_used_by_alt_index,
+                                        const bool saturated, const StashEntry *stash,
+                                        const size_t stash_size, const size_t index,
+                                        const uint32_t hash) -> Status {
+    if (saturated)
       return Ok;
 
-    if constexpr (ENABLE_FINGERPRINT_GROWTH) {
-      if (table->match_hash_in_buckets(index, index2, hash))
+    const uint32_t tag = table.gen_tag(hash);
+
+    if constexpr (QUERY_STRATEGY == QueryStrategy::PrimaryFirst) {
+      if (find_in_bucket(table, index, hash, tag))
+        return Ok;
+    }
+
+    const size_t index2 = alt_index(index, tag, bits_to_shift_used_by_alt_index);
+
+    if (stash_size != 0 &&
+        find_in_stash(table, stash, stash_size, index, index2, hash) != STASH_SIZE)
+      return Ok;
+
+    if constexpr (QUERY_STRATEGY == QueryStrategy::PrimaryFirst) {
+      if (find_in_bucket(table, index2, hash, tag))
+        return Ok;
+    } else if constexpr (QUERY_STRATEGY == QueryStrategy::Branchless) {
+      bool found;
+      if constexpr (ENABLE_FINGERPRINT_GROWTH)
+        found = table.match_hash_in_buckets_branchless(index, index2, hash);
+      else
+        found = table.find_tag_in_buckets_branchless(index, index2, tag);
+      if (found)
+        return Ok;
+    } else if constexpr (ENABLE_FINGERPRINT_GROWTH) {
+      if (table.match_hash_in_buckets(index, index2, hash))
         return Ok;
     } else {
-      const uint32_t tag = table->gen_tag(hash);
-      if (table->find_tag_in_buckets(index, index2, tag))
+      if (table.find_tag_in_buckets(index, index2, tag))
         return Ok;
     }
 
@@ -182,30 +558,323 @@ public:
       if (table->remove_hash_from_buckets(index, index2, hash)) {
         num_items--;
         // NOLINTNEXTLINE(cppcoreguidelines-avoid-goto)
-        goto try_eliminate_victim;
+        goto try_empty_stash;
       }
     } else {
       if (table->remove_tag_from_bucket(index, tag) || table->remove_tag_from_bucket(index2, tag)) {
         num_items--;
         // NOLINTNEXTLINE(cppcoreguidelines-avoid-goto)
-        goto try_eliminate_victim;
+        goto try_empty_stash;
       }
     }
 
-    if (victim_used_ && (victim_index_ == index || victim_index_ == index2) && victim_tag_ == tag) {
-      victim_used_ = false;
+    if (const size_t pos = find_in_stash(*table, stash_, stash_size_, index, index2, hash);
+        pos != STASH_SIZE) {
+      stash_[pos] = stash_[--stash_size_];
+      dirty = true;
       return Ok;
     }
 
+    // The item must be one of the lost ones, after the last of which the segment is no longer
+    // saturated
+    if (num_lost != 0) {
+      num_lost--;
+      dirty = true;
+      return Ok;
+    }
     return NotFound;
 
-  try_eliminate_victim:
-    if (victim_used_) {
-      victim_used_ = false;
-      insert(victim_index_, victim_tag_);
+  try_empty_stash:
+    dirty = true;
+    if (stash_size_ != 0) {
+      // The freed slot may make room for stashed tags, those that still do not fit are stashed
+      // again
+      StashEntry stashed[STASH_SIZE];
+      const size_t num_stashed = take_stash(stashed);
+      for (size_t i = 0; i < num_stashed; i++)
+        insert_tag(stashed[i].index, stashed[i].tag);
     }
     return Ok;
   }
+
+  /**
+   * @brief Write the segment to a stream: its metadata, its stash (`STASH_SIZE` entries, the unused
+   * ones zeroed), its lookup table slots (padded to 8 bytes) and the raw bytes of its table. The
+   * table starts at an 8-byte aligned offset if the record does.
+   *
+   * @param os The stream to write to.
+   * @return True if the whole segment is written.
+   */
+  auto save(std::ostream &os) const -> bool {
+    const uint64_t metadata[] = {k_bits_per_item, num_items, num_lost, stash_size_,
+                                 lut_slots_count};
+    if (!write_bytes(os, metadata, sizeof(metadata)) || !write_bytes(os, stash_, sizeof(stash_)))
+      return false;
+    for (uint32_t i = 0; i < lut_slots_count; i++)
+      if (!write_pod(os, first_lut_slot + i))
+        return false;
+    if (lut_slots_count % 2 != 0 && !write_pod(os, uint32_t{0}))
+      return false;
+    return table->save(os);
+  }
+
+  /**
+   * @brief Read a segment written by `save` from a stream.
+   *
+   * @param is The stream to read from.
+   * @param high_bits_used_by_alt_index See the constructor.
+   * @param mapped_base If not `nullptr`, the stream reads from memory starting at this address
+   * (see `MemoryStreamBuffer`), and the table borrows its bytes in place instead of copying them.
+   * @return The segment, or `nullptr` if the stream fails or the segment is malformed.
+   */
+  [[nodiscard]] static auto load(std::istream &is, const size_t high_bits_used_by_alt_index,
+                                 uint8_t *mapped_base = nullptr) -> Segment * {
+    uint64_t metadata[5];
+    StashEntry stash[STASH_SIZE];
+    if (!read_bytes(is, metadata, sizeof(metadata)) || !read_bytes(is, stash, sizeof(stash)))
+      return nullptr;
+    const auto [bits_per_item, num_items, num_lost, stash_size, lut_slots_count] = metadata;
+    if (bits_per_item == 0 || bits_per_item > (ENABLE_FINGERPRINT_GROWTH ? 31 : 32) ||
+        bits_per_item < high_bits_used_by_alt_index ||
+        !Table::supports_bits_per_tag(bits_per_item) ||
+        num_items > BUCKETS_PER_SEG * SLOTS_PER_BUCKET || !valid_stash(stash, stash_size) ||
+        lut_slots_count == 0 || lut_slots_count > LOOKUP_TABLE_SIZE)
+      return nullptr;
+
+    // The slots are written one by one, but must be contiguous
+    uint32_t first_slot;
+    if (!read_pod(is, first_slot))
+      return nullptr;
+    for (uint32_t i = 1; i < lut_slots_count; i++) {
+      uint32_t slot;
+      if (!read_pod(is, slot) || slot != first_slot + i)
+        return nullptr;
+    }
+    uint32_t padding;
+    if (lut_slots_count % 2 != 0 && !read_pod(is, padding))
+      return nullptr;
+
+    uint8_t *table_data = nullptr;
+    if (mapped_base != nullptr) {
+      table_data = mapped_base + static_cast<std::streamoff>(is.tellg());
+      const auto table_size = Table::size_in_bytes(BUCKETS_PER_SEG, bits_per_item);
+      if (!is.seekg(static_cast<std::streamoff>(table_size), std::ios_base::cur))
+        return nullptr;
+    }
+
+    auto *seg =
+        new Segment(BUCKETS_PER_SEG, bits_per_item, high_bits_used_by_alt_index, table_data);
+    seg->num_items = num_items;
+    seg->num_lost = num_lost;
+    std::copy_n(stash, stash_size, seg->stash_);
+    seg->stash_size_ = static_cast<uint32_t>(stash_size);
+    seg->first_lut_slot = first_slot;
+    seg->lut_slots_count = static_cast<uint32_t>(lut_slots_count);
+    if (mapped_base == nullptr && !seg->table->load(is)) {
+      delete seg;
+      return nullptr;
+    }
+    return seg;
+  }
+
+  /**
+   * @brief Write the tags of the segment to a stream, more compactly than `save` unless the table
+   * is nearly full: a header of 32-bit integers (bits per item, number of tags, saturation, the
+   * number of stashed tags, the first lookup table slot, the number of lookup table slots, which
+   * are contiguous, and the size of the records in bytes), the stashed tags, then a record per tag
+   * in bucket order, packed by `BitWriter`: the bucket as the difference from the previous
+   * record's bucket in unary code, and the tag in as many bits as in the table.
+   *
+   * @param os The stream to write to.
+   * @return True if the whole segment is written.
+   */
+  auto export_tags(std::ostream &os) const -> bool {
+    const size_t tag_bits = k_bits_per_item + (ENABLE_FINGERPRINT_GROWTH ? 1 : 0);
+    std::vector<uint8_t> records;
+    records.reserve((num_items * (tag_bits + 1) + BUCKETS_PER_SEG + 7) / 8);
+    BitWriter writer(records);
+    uint32_t num_tags = 0;
+    size_t last_bucket = 0;
+    for (size_t bucket = 0; bucket < BUCKETS_PER_SEG; bucket++)
+      for (size_t slot = 0; slot < SLOTS_PER_BUCKET; slot++) {
+        const uint32_t tag = table->read_tag(bucket, slot);
+        if (tag == 0)
+          continue;
+        writer.write_unary(bucket - last_bucket);
+        writer.write(tag, tag_bits);
+        last_bucket = bucket;
+        num_tags++;
+      }
+    writer.flush();
+
+    const uint32_t header[] = {static_cast<uint32_t>(k_bits_per_item),
+                               num_tags,
+                               static_cast<uint32_t>(std::min<uint64_t>(num_lost, UINT32_MAX)),
+                               stash_size_,
+                               first_lut_slot,
+                               lut_slots_count,
+                               static_cast<uint32_t>(records.size())};
+    return write_bytes(os, header, sizeof(header)) &&
+           write_bytes(os, stash_, sizeof(StashEntry) * stash_size_) &&
+           write_bytes(os, records.data(), records.size());
+  }
+
+  /**
+   * @brief Read a segment written by `export_tags` from a stream. Each tag is written to the next
+   * free slot of its bucket, so no cuckoo kick is needed.
+   *
+   * @param is The stream to read from.
+   * @param high_bits_used_by_alt_index See the constructor.
+   * @return The segment, or `nullptr` if reading fails or the data is malformed.
+   */
+  [[nodiscard]] static auto import_tags(std::istream &is, const size_t high_bits_used_by_alt_index)
+      -> Segment * {
+    uint32_t header[7];
+    if (!read_bytes(is, header, sizeof(header)))
+      return nullptr;
+    const auto [bits_per_item, num_tags, num_lost, stash_size, first_slot, lut_slots_count,
+                records_size] = header;
+    const size_t tag_bits = bits_per_item + (ENABLE_FINGERPRINT_GROWTH ? 1 : 0);
+    if (bits_per_item == 0 || bits_per_item > (ENABLE_FINGERPRINT_GROWTH ? 31 : 32) ||
+        bits_per_item < high_bits_used_by_alt_index ||
+        !Table::supports_bits_per_tag(bits_per_item) ||
+        num_tags > BUCKETS_PER_SEG * SLOTS_PER_BUCKET || stash_size > STASH_SIZE ||
+        lut_slots_count == 0 || lut_slots_count > LOOKUP_TABLE_SIZE ||
+        first_slot > LOOKUP_TABLE_SIZE - lut_slots_count ||
+        records_size > (num_tags * (tag_bits + 1) + BUCKETS_PER_SEG + 7) / 8)
+      return nullptr;
+    StashEntry stash[STASH_SIZE]{};
+    std::vector<uint8_t> records(records_size);
+    if (!read_bytes(is, stash, sizeof(StashEntry) * stash_size) ||
+        !valid_stash(stash, stash_size) || !read_bytes(is, records.data(), records_size))
+      return nullptr;
+
+    auto *seg = new Segment(BUCKETS_PER_SEG, bits_per_item, high_bits_used_by_alt_index);
+    BitReader reader(records.data(), records.size());
+    size_t bucket = 0;
+    size_t slot = 0;
+    for (uint32_t i = 0; i < num_tags; i++) {
+      size_t bucket_delta;
+      uint32_t tag;
+      if (!reader.read_unary(BUCKETS_PER_SEG - 1 - bucket, bucket_delta) ||
+          !reader.read(tag_bits, tag) || tag == 0) {
+        delete seg;
+        return nullptr;
+      }
+      bucket += bucket_delta;
+      slot = bucket_delta == 0 && i != 0 ? slot + 1 : 0;
+      if (slot >= SLOTS_PER_BUCKET) {
+        delete seg;
+        return nullptr;
+      }
+      seg->table->insert_tag_to_bucket(bucket, tag);
+    }
+
+    seg->num_items = num_tags;
+    seg->num_lost = num_lost;
+    std::copy_n(stash, stash_size, seg->stash_);
+    seg->stash_size_ = stash_size;
+    seg->first_lut_slot = first_slot;
+    seg->lut_slots_count = lut_slots_count;
+    return seg;
+  }
+
+  /**
+   * @brief Whether the segment should be expanded: it holds more items than its capacity, or tags
+   * had to be stashed, which is the first sign that it is about to overflow.
+   *
+   * @return True if the segment should be expanded.
+   */
+  [[nodiscard]] auto needs_expansion() const -> bool {
+    return num_items > capacity || stash_size_ != 0;
+  }
+
+  /**
+   * @brief Whether the segment has lost items, see `num_lost`.
+   *
+   * @return True if the segment answers every query positively.
+   */
+  [[nodiscard]] auto saturated() const -> bool { return num_lost != 0; }
+
+  /**
+   * @brief Take all tags out of the stash, e.g., to insert them again.
+   *
+   * @param entries The tags taken, `STASH_SIZE` of them at most.
+   * @return The number of tags taken.
+   */
+  auto take_stash(StashEntry *entries) -> size_t {
+    const size_t count = stash_size_;
+    std::copy_n(stash_, count, entries);
+    stash_size_ = 0;
+    dirty = dirty || count != 0;
+    return count;
+  }
+
+  /**
+   * @brief Get the tags kept outside the table, see `insert_tag`.
+   *
+   * @return The stashed tags.
+   */
+  [[nodiscard]] auto stash() const -> std::span<const StashEntry> {
+    return {stash_, stash_size_};
+  }
+
+  /**
+   * @brief Fold all tags of a sibling segment (the one split from this segment by
+   * `DFF::expand`) back into this segment. This is the inverse of the tag moving in `DFF::expand`.
+   *
+   * The tags are inserted into a scratch copy of the table, so if any of them does not fit in the
+   * table (it would have to be stashed), both segments are left untouched and `NotEnoughSpace` is
+   * returned.
+   *
+   * @param sibling The sibling segment to absorb. It is not modified.
+   * @return The status of the operation.
+   */
+  auto absorb(const Segment &sibling) -> Status {
+    auto *old_table = table;
+    const size_t old_num_items = num_items;
+    const uint64_t old_num_kicks = num_kicks;
+    const uint64_t old_num_lost = num_lost;
+    StashEntry old_stash[STASH_SIZE];
+    // The stash of this segment is inserted back after the sibling's tags
+    const size_t old_stash_size = take_stash(old_stash);
+
+    table = new Table(BUCKETS_PER_SEG, k_bits_per_item);
+    table->copy_from(*old_table);
+
+    // A merged segment with stashed tags would be expanded again right away, so give up as soon as
+    // a tag has to be stashed
+    const auto fits = [this](const Status res) { return res == Ok && stash_size_ == 0; };
+    Status res = Ok;
+    for (size_t bucket = 0; bucket < BUCKETS_PER_SEG && fits(res); bucket++)
+      for (size_t slot = 0; slot < SLOTS_PER_BUCKET && fits(res); slot++) {
+        const uint32_t tag = sibling.table->read_tag(bucket, slot);
+        if (tag != 0)
+          res = insert_tag(bucket, trim_tag(tag, sibling.k_bits_per_item));
+      }
+    for (const StashEntry &entry : sibling.stash())
+      if (fits(res))
+        res = insert_tag(entry.index, trim_tag(entry.tag, sibling.k_bits_per_item));
+    for (size_t i = 0; i < old_stash_size && fits(res); i++)
+      res = insert_tag(old_stash[i].index, old_stash[i].tag);
+
+    if (!fits(res)) {
+      delete table;
+      table = old_table;
+      num_items = old_num_items;
+      num_kicks = old_num_kicks;
+      num_lost = old_num_lost;
+      std::copy_n(old_stash, old_stash_size, stash_);
+      stash_size_ = static_cast<uint32_t>(old_stash_size);
+      return NotEnoughSpace;
+    }
+
+    delete old_table;
+    // The lost items of both segments may belong to the merged one
+    num_lost += sibling.num_lost;
+    dirty = true;
+    return Ok;
+  }
 };
 
 } // namespace dff
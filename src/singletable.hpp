@@ -5,17 +5,44 @@
 
 #pragma once
 
+#include <algorithm>
+#include <bit>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
-#include <cstdlib>
 #include <cstring>
+#include <istream>
+#include <new>
+#include <ostream>
+#include <utility>
 
 #include "predefine.hpp"
+#include "utils/io.hpp"
+#include "utils/perm_encoding.hpp"
 
 namespace dff {
 
-template <bool ENABLE_FINGERPRINT_GROWTH> class SingleTable {
+template <bool ENABLE_FINGERPRINT_GROWTH, typename Config = DefaultConfig> class SingleTable {
+  static constexpr size_t SLOTS_PER_BUCKET = Config::SLOTS_PER_BUCKET;
+  // Bits per tag fixed at compile time, or 0 if given at runtime
+  static constexpr size_t FIXED_BITS_PER_TAG = Config::BITS_PER_TAG;
+  // Whether buckets are semi-sorted, as in the `PackedTable` of the Cuckoo Filter implementation:
+  // the tags of a bucket are sorted by their low 4 bits, which are encoded together in 12 bits
+  // instead of 16 (see `encode_nibbles`), followed by the other bits of the tags. The slots of a
+  // tag thus change whenever its bucket is written
+  static constexpr bool SEMI_SORTED = Config::SEMI_SORTED_BUCKETS;
+  // Bits of a semi-sorted bucket not taken by the other bits of the tags
+  static constexpr size_t NIBBLE_CODE_BITS = 12;
+  // Owned tag storage is aligned to cache lines, so that a block of alternative buckets (see
+  // `Config::ALT_BLOCK_BUCKETS`) is not split across lines
+  static constexpr std::align_val_t DATA_ALIGNMENT{64};
+
+  static_assert(FIXED_BITS_PER_TAG == 0 || !ENABLE_FINGERPRINT_GROWTH,
+                "Fingerprint growth needs the bits per tag to be given at runtime");
+  // Fixed width tags are read as little endian words, matching the layout of `read_bits`
+  static_assert(FIXED_BITS_PER_TAG == 0 || std::endian::native == std::endian::little,
+                "Fixed bits per tag need a little endian platform");
+
   /**
    * @brief Bits per tag. When `ENABLE_FINGERPRINT_GROWTH` is true, the actual bits per tag is
    * `k_bits_per_tag + 1`.
@@ -25,24 +52,11 @@ template <bool ENABLE_FINGERPRINT_GROWTH> class SingleTable {
 
   uint8_t *data_;
   size_t num_buckets_;
-
-  /**
-   * @brief Whether the hash (must be a 32-bit uint hash) matches the tag (fingerprint of several
-   * high bits of the hash).
-   *
-   * @param hash The hash to check (must be a 32-bit uint hash).
-   * @param tag The tag to check (fingerprint of several high bits of the hash).
-   * @return True if the hash matches the tag.
-   */
-  [[nodiscard]] auto matches_tag(const uint32_t hash, const uint32_t tag) const -> bool {
-    if constexpr (ENABLE_FINGERPRINT_GROWTH) {
-      const auto to_shift = __builtin_ctz(tag) + 1;
-      const auto remain = k_bits_per_tag_ + 1 - to_shift;
-      return (hash >> (32 - remain)) == (tag >> to_shift);
-    } else {
-      return gen_tag(hash) == tag;
-    }
-  }
+  // Size of `data_` in bytes (including padding)
+  size_t num_bytes_;
+  // Whether `data_` is allocated by this table, otherwise it is borrowed (e.g., from a memory
+  // mapped file) and must outlive the table
+  bool owns_data_ = true;
 
   [[nodiscard]] auto read_bits(const size_t from, const size_t length) const -> uint32_t {
     const size_t from_byte = from >> 3;
@@ -119,42 +133,255 @@ template <bool ENABLE_FINGERPRINT_GROWTH> class SingleTable {
     }
   }
 
+  /**
+   * @brief Read the `index`-th tag of a table with fixed bits per tag. 8, 16 and 32-bit tags are
+   * whole words, and 12-bit tags are packed in pairs of 3 bytes, read through a 2-byte window.
+   *
+   * @param index The index of the tag (`bucket * SLOTS_PER_BUCKET + slot`).
+   * @return The tag.
+   */
+  [[nodiscard]] auto read_fixed_tag(const size_t index) const -> uint32_t {
+    if constexpr (FIXED_BITS_PER_TAG == 8) {
+      return data_[index];
+    } else if constexpr (FIXED_BITS_PER_TAG == 12) {
+      uint16_t window;
+      memcpy(&window, data_ + index * 3 / 2, sizeof(window));
+      return (window >> ((index & 1) << 2)) & 0xfff;
+    } else if constexpr (FIXED_BITS_PER_TAG == 16) {
+      uint16_t tag;
+      memcpy(&tag, data_ + index * 2, sizeof(tag));
+      return tag;
+    } else {
+      uint32_t tag;
+      memcpy(&tag, data_ + index * 4, sizeof(tag));
+      return tag;
+    }
+  }
+
+  /**
+   * @brief Write the `index`-th tag of a table with fixed bits per tag, see `read_fixed_tag`.
+   *
+   * @param index The index of the tag (`bucket * SLOTS_PER_BUCKET + slot`).
+   * @param tag The tag to write.
+   */
+  void write_fixed_tag(const size_t index, const uint32_t tag) {
+    if constexpr (FIXED_BITS_PER_TAG == 8) {
+      data_[index] = static_cast<uint8_t>(tag);
+    } else if constexpr (FIXED_BITS_PER_TAG == 12) {
+      const uint32_t shift = (index & 1) << 2;
+      const uint32_t mask = 0xfffU << shift;
+      uint16_t window;
+      memcpy(&window, data_ + index * 3 / 2, sizeof(window));
+      window = static_cast<uint16_t>((window & ~mask) | ((tag << shift) & mask));
+      memcpy(data_ + index * 3 / 2, &window, sizeof(window));
+    } else if constexpr (FIXED_BITS_PER_TAG == 16) {
+      const auto word = static_cast<uint16_t>(tag);
+      memcpy(data_ + index * 2, &word, sizeof(word));
+    } else {
+      memcpy(data_ + index * 4, &tag, sizeof(tag));
+    }
+  }
+
+  // Bits per tag, including the unary mask bit of fingerprint growth
+  [[nodiscard]] auto tag_bits() const -> size_t {
+    return ENABLE_FINGERPRINT_GROWTH ? k_bits_per_tag_ + 1 : k_bits_per_tag_;
+  }
+
+  /**
+   * @brief Read the tags of a semi-sorted bucket, sorted by their low 4 bits.
+   *
+   * @param bucket The index of the bucket.
+   * @param tags The tags of the bucket in slot order.
+   */
+  void read_semi_sorted_bucket(const size_t bucket, uint32_t *tags) const {
+    const size_t high_bits = tag_bits() - 4;
+    const size_t from = bucket * (NIBBLE_CODE_BITS + SLOTS_PER_BUCKET * high_bits);
+    const uint32_t nibbles = decode_nibbles(read_bits(from, NIBBLE_CODE_BITS));
+    for (size_t slot = 0; slot < SLOTS_PER_BUCKET; slot++)
+      tags[slot] = (read_bits(from + NIBBLE_CODE_BITS + slot * high_bits, high_bits) << 4) |
+                   ((nibbles >> (slot * 4)) & 0xf);
+  }
+
+  /**
+   * @brief Sort the tags of a semi-sorted bucket by their low 4 bits (then by the other bits, so
+   * that the same tags are always written the same way) and write them.
+   *
+   * @param bucket The index of the bucket.
+   * @param tags The tags of the bucket, sorted in place.
+   */
+  void write_semi_sorted_bucket(const size_t bucket, uint32_t *tags) {
+    // Rotating the low 4 bits to the top orders the tags as wanted
+    const auto compare_swap = [tags](const size_t i, const size_t j) {
+      if (std::rotr(tags[i], 4) > std::rotr(tags[j], 4))
+        std::swap(tags[i], tags[j]);
+    };
+    compare_swap(0, 1);
+    compare_swap(2, 3);
+    compare_swap(0, 2);
+    compare_swap(1, 3);
+    compare_swap(1, 2);
+
+    const size_t high_bits = tag_bits() - 4;
+    const size_t from = bucket * (NIBBLE_CODE_BITS + SLOTS_PER_BUCKET * high_bits);
+    write_bits(from, NIBBLE_CODE_BITS,
+               encode_nibbles(tags[0] & 0xf, tags[1] & 0xf, tags[2] & 0xf, tags[3] & 0xf));
+    for (size_t slot = 0; slot < SLOTS_PER_BUCKET; slot++)
+      write_bits(from + NIBBLE_CODE_BITS + slot * high_bits, high_bits, tags[slot] >> 4);
+  }
+
+  void swap(SingleTable &other) noexcept {
+    std::swap(k_bits_per_tag_, other.k_bits_per_tag_);
+    std::swap(k_bits_to_shift_used_by_gen_tag_, other.k_bits_to_shift_used_by_gen_tag_);
+    std::swap(data_, other.data_);
+    std::swap(num_buckets_, other.num_buckets_);
+    std::swap(num_bytes_, other.num_bytes_);
+    std::swap(owns_data_, other.owns_data_);
+  }
+
 public:
-  SingleTable(const SingleTable &) = default;
-  SingleTable(SingleTable &&) = default;
-  auto operator=(const SingleTable &) -> SingleTable & = default;
-  auto operator=(SingleTable &&) -> SingleTable & = default;
+  // Deep copy, the tags are copied with a single `memcpy` (even if borrowed)
+  SingleTable(const SingleTable &other)
+      : k_bits_per_tag_(other.k_bits_per_tag_),
+        k_bits_to_shift_used_by_gen_tag_(other.k_bits_to_shift_used_by_gen_tag_),
+        data_(new (DATA_ALIGNMENT) uint8_t[other.num_bytes_]), num_buckets_(other.num_buckets_),
+        num_bytes_(other.num_bytes_) {
+    memcpy(data_, other.data_, num_bytes_);
+  }
+  SingleTable(SingleTable &&other) noexcept
+      : k_bits_per_tag_(other.k_bits_per_tag_),
+        k_bits_to_shift_used_by_gen_tag_(other.k_bits_to_shift_used_by_gen_tag_),
+        data_(std::exchange(other.data_, nullptr)), num_buckets_(other.num_buckets_),
+        num_bytes_(std::exchange(other.num_bytes_, 0)), owns_data_(other.owns_data_) {}
+  auto operator=(const SingleTable &other) -> SingleTable & {
+    SingleTable copy(other);
+    swap(copy);
+    return *this;
+  }
+  auto operator=(SingleTable &&other) noexcept -> SingleTable & {
+    swap(other);
+    return *this;
+  }
 
   /**
    * @brief Create a new single table.
    *
    * @param num_buckets Bucket count.
    * @param bits_per_tag Bits per tag. When `ENABLE_FINGERPRINT_GROWTH` is true, the actual bits per
-   * tag is `bits_per_tag + 1`.
+   * tag is `bits_per_tag + 1`. Must be supported by the table (see `supports_bits_per_tag`).
    */
   explicit SingleTable(const size_t num_buckets, const size_t bits_per_tag)
       : num_buckets_(num_buckets), k_bits_per_tag_(bits_per_tag),
         k_bits_to_shift_used_by_gen_tag_(32UZ - bits_per_tag) {
+    assert(supports_bits_per_tag(bits_per_tag));
+    num_bytes_ = size_in_bytes(num_buckets, bits_per_tag);
+    data_ = new (DATA_ALIGNMENT) uint8_t[num_bytes_];
+    memset(data_, 0, num_bytes_);
+  }
+
+  /**
+   * @brief Create a single table on borrowed tag storage, e.g., the bytes written by `save` in a
+   * memory mapped file. The storage is not copied, and must outlive the table.
+   *
+   * @param num_buckets Bucket count.
+   * @param bits_per_tag Bits per tag (see the other constructor).
+   * @param data The tag storage, `size_in_bytes(num_buckets, bits_per_tag)` bytes.
+   */
+  explicit SingleTable(const size_t num_buckets, const size_t bits_per_tag, uint8_t *data)
+      : k_bits_per_tag_(bits_per_tag), k_bits_to_shift_used_by_gen_tag_(32UZ - bits_per_tag),
+        data_(data), num_buckets_(num_buckets),
+        num_bytes_(size_in_bytes(num_buckets, bits_per_tag)), owns_data_(false) {
+    assert(supports_bits_per_tag(bits_per_tag));
+  }
+
+  ~SingleTable() {
+    if (owns_data_)
+      ::operator delete[](data_, DATA_ALIGNMENT);
+    data_ = nullptr;
+  }
+
+  /**
+   * @brief Get the size of the underlying tag storage in bytes.
+   *
+   * @return The size in bytes.
+   */
+  [[nodiscard]] auto size_in_bytes() const -> size_t { return num_bytes_; }
+
+  /**
+   * @brief Get the underlying tag storage, e.g., to locate borrowed storage in a memory region.
+   *
+   * @return The tag storage.
+   */
+  [[nodiscard]] auto data() const -> const uint8_t * { return data_; }
+
+  /**
+   * @brief Get the size of the underlying tag storage of a table in bytes.
+   *
+   * @param num_buckets Bucket count.
+   * @param bits_per_tag Bits per tag (see the constructor).
+   * @return The size in bytes.
+   */
+  [[nodiscard]] static constexpr auto size_in_bytes(const size_t num_buckets,
+                                                    const size_t bits_per_tag) -> size_t {
     size_t total_size;
-    if constexpr (ENABLE_FINGERPRINT_GROWTH)
+    if constexpr (SEMI_SORTED) {
+      const size_t tag_bits = ENABLE_FINGERPRINT_GROWTH ? bits_per_tag + 1 : bits_per_tag;
+      total_size = (num_buckets * (NIBBLE_CODE_BITS + SLOTS_PER_BUCKET * (tag_bits - 4)) + 7) >> 3;
+    } else if constexpr (ENABLE_FINGERPRINT_GROWTH) {
       total_size = (num_buckets * SLOTS_PER_BUCKET * (bits_per_tag + 1) + 7) >> 3;
-    else
+    } else {
       total_size = (num_buckets * SLOTS_PER_BUCKET * (bits_per_tag) + 7) >> 3;
-    total_size = (total_size + 7) & ~7; // Add padding for 8-byte alignment
-    data_ = new uint8_t[total_size];
-    memset(data_, 0, total_size);
+    }
+    return (total_size + 7) & ~7; // Add padding for 8-byte alignment
   }
 
-  ~SingleTable() {
-    delete[] data_;
-    data_ = nullptr;
+  /**
+   * @brief Whether a table can hold tags of the given width, i.e., its width is not fixed to
+   * another one at compile time (see `Config::BITS_PER_TAG`), and is enough for semi-sorting.
+   *
+   * @param bits_per_tag Bits per tag (see the constructor).
+   * @return True if the width is supported.
+   */
+  [[nodiscard]] static constexpr auto supports_bits_per_tag(const size_t bits_per_tag) -> bool {
+    // Semi-sorted tags need more than the 4 bits encoded together
+    if constexpr (SEMI_SORTED)
+      return bits_per_tag > 4;
+    return FIXED_BITS_PER_TAG == 0 || bits_per_tag == FIXED_BITS_PER_TAG;
   }
 
+  /**
+   * @brief Overwrite all tags with the ones of another table. Both tables must have the same
+   * number of buckets and bits per tag.
+   *
+   * @param other The table to copy from.
+   */
+  void copy_from(const SingleTable &other) {
+    assert(num_bytes_ == other.num_bytes_);
+    memcpy(data_, other.data_, num_bytes_);
+  }
+
+  /**
+   * @brief Write the raw tag storage to a stream with a single sequential write.
+   *
+   * @param os The stream to write to.
+   * @return True if all `size_in_bytes()` bytes are written.
+   */
+  auto save(std::ostream &os) const -> bool { return write_bytes(os, data_, num_bytes_); }
+
+  /**
+   * @brief Overwrite the raw tag storage with the one written by `save` from a table with the
+   * same number of buckets and bits per tag.
+   *
+   * @param is The stream to read from.
+   * @return True if all `size_in_bytes()` bytes are read.
+   */
+  auto load(std::istream &is) -> bool { return read_bytes(is, data_, num_bytes_); }
+
   [[nodiscard]] auto gen_tag(const uint32_t hash) const -> uint32_t {
     if constexpr (ENABLE_FINGERPRINT_GROWTH) {
       return ((hash >> k_bits_to_shift_used_by_gen_tag_) << 1) | 1;
     } else {
-      uint32_t tag = hash >> k_bits_to_shift_used_by_gen_tag_;
+      uint32_t tag = FIXED_BITS_PER_TAG != 0 ? hash >> (32 - FIXED_BITS_PER_TAG)
+                                             : hash >> k_bits_to_shift_used_by_gen_tag_;
       // Avoid tag 0
       if (tag == 0)
         tag = 1;
@@ -162,6 +389,47 @@ public:
     }
   }
 
+  /**
+   * @brief Whether the hash (must be a 32-bit uint hash) matches the tag (fingerprint of several
+   * high bits of the hash).
+   *
+   * @param hash The hash to check (must be a 32-bit uint hash).
+   * @param tag The tag to check (fingerprint of several high bits of the hash).
+   * @return True if the hash matches the tag.
+   */
+  [[nodiscard]] auto matches_tag(const uint32_t hash, const uint32_t tag) const -> bool {
+    if constexpr (ENABLE_FINGERPRINT_GROWTH) {
+      // Empty slot (`__builtin_ctz(0)` is undefined)
+      if (tag == 0)
+        return false;
+      const auto to_shift = __builtin_ctz(tag) + 1;
+      const auto remain = k_bits_per_tag_ + 1 - to_shift;
+      return (hash >> (32 - remain)) == (tag >> to_shift);
+    } else {
+      return gen_tag(hash) == tag;
+    }
+  }
+
+  /**
+   * @brief Same as `matches_tag` with fingerprint growth enabled, but without branching on an
+   * empty slot, see `match_hash_in_buckets_branchless`. Without fingerprint growth, tags are
+   * compared with the generated tag directly (see `find_tag_in_buckets_branchless`).
+   *
+   * @param hash The hash to match (must be a 32-bit uint hash).
+   * @param tag The tag to match.
+   * @return True if the tag matches the hash.
+   */
+  [[nodiscard]] auto matches_tag_branchless(const uint32_t hash, const uint32_t tag) const -> bool
+    requires ENABLE_FINGERPRINT_GROWTH
+  {
+    // An empty slot is matched as the tag 1 (`__builtin_ctz(0)` is undefined), then rejected
+    const uint32_t nonzero = tag | static_cast<uint32_t>(tag == 0);
+    const auto to_shift = __builtin_ctz(nonzero) + 1;
+    const auto remain = k_bits_per_tag_ + 1 - to_shift;
+    const bool matches = (hash >> (32 - remain)) == (nonzero >> to_shift);
+    return (static_cast<uint32_t>(tag != 0) & static_cast<uint32_t>(matches)) != 0;
+  }
+
   /**
    * @brief Read tag from a bucket slot. Does not handle unary mask (i.e., just read the raw tag).
    *
@@ -170,7 +438,15 @@ public:
    * @return The tag.
    */
   [[nodiscard]] auto read_tag(const size_t bucket, const size_t slot) const -> uint32_t {
-    if constexpr (ENABLE_FINGERPRINT_GROWTH) {
+    if constexpr (SEMI_SORTED) {
+      const size_t high_bits = tag_bits() - 4;
+      const size_t from = bucket * (NIBBLE_CODE_BITS + SLOTS_PER_BUCKET * high_bits);
+      const uint32_t nibbles = decode_nibbles(read_bits(from, NIBBLE_CODE_BITS));
+      return (read_bits(from + NIBBLE_CODE_BITS + slot * high_bits, high_bits) << 4) |
+             ((nibbles >> (slot * 4)) & 0xf);
+    } else if constexpr (FIXED_BITS_PER_TAG != 0) {
+      return read_fixed_tag(bucket * SLOTS_PER_BUCKET + slot);
+    } else if constexpr (ENABLE_FINGERPRINT_GROWTH) {
       const size_t from = (bucket * SLOTS_PER_BUCKET + slot) * (k_bits_per_tag_ + 1);
       return read_bits(from, k_bits_per_tag_ + 1);
     } else {
@@ -181,13 +457,21 @@ public:
 
   /**
    * @brief Write tag to a bucket slot. Does not handle unary mask (i.e., just write the raw tag).
+   * In a semi-sorted table, the other tags of the bucket may move to other slots.
    *
    * @param bucket The index of the bucket.
    * @param slot The index of the tag in the bucket (slot index).
    * @param tag The tag to write.
    */
   void write_tag(const size_t bucket, const size_t slot, const uint32_t tag) {
-    if constexpr (ENABLE_FINGERPRINT_GROWTH) {
+    if constexpr (SEMI_SORTED) {
+      uint32_t tags[SLOTS_PER_BUCKET];
+      read_semi_sorted_bucket(bucket, tags);
+      tags[slot] = tag;
+      write_semi_sorted_bucket(bucket, tags);
+    } else if constexpr (FIXED_BITS_PER_TAG != 0) {
+      write_fixed_tag(bucket * SLOTS_PER_BUCKET + slot, tag);
+    } else if constexpr (ENABLE_FINGERPRINT_GROWTH) {
       const size_t from = (bucket * SLOTS_PER_BUCKET + slot) * (k_bits_per_tag_ + 1);
       write_bits(from, k_bits_per_tag_ + 1, tag);
     } else {
@@ -196,6 +480,39 @@ public:
     }
   }
 
+  /**
+   * @brief Read all tags of a bucket, decoding a semi-sorted bucket once.
+   *
+   * @param bucket The index of the bucket.
+   * @param tags The tags in slot order.
+   */
+  void read_bucket(const size_t bucket, uint32_t (&tags)[SLOTS_PER_BUCKET]) const {
+    if constexpr (SEMI_SORTED) {
+      read_semi_sorted_bucket(bucket, tags);
+    } else {
+      for (size_t slot = 0; slot < SLOTS_PER_BUCKET; slot++)
+        tags[slot] = read_tag(bucket, slot);
+    }
+  }
+
+  /**
+   * @brief Overwrite all tags of a bucket, encoding a semi-sorted bucket once (the tags may then
+   * end up in other slots).
+   *
+   * @param bucket The index of the bucket.
+   * @param tags The tags in slot order.
+   */
+  void write_bucket(const size_t bucket, const uint32_t (&tags)[SLOTS_PER_BUCKET]) {
+    if constexpr (SEMI_SORTED) {
+      uint32_t sorted[SLOTS_PER_BUCKET];
+      std::copy_n(tags, SLOTS_PER_BUCKET, sorted);
+      write_semi_sorted_bucket(bucket, sorted);
+    } else {
+      for (size_t slot = 0; slot < SLOTS_PER_BUCKET; slot++)
+        write_tag(bucket, slot, tags[slot]);
+    }
+  }
+
   /**
    * @brief Remove the tag from the bucket slot (write 0 to the slot).
    *
@@ -215,6 +532,16 @@ public:
    */
   [[nodiscard]] auto match_hash_in_buckets(const size_t bucket1, const size_t bucket2,
                                            const uint32_t hash) const -> bool {
+    if constexpr (SEMI_SORTED) {
+      uint32_t tags1[SLOTS_PER_BUCKET];
+      uint32_t tags2[SLOTS_PER_BUCKET];
+      read_semi_sorted_bucket(bucket1, tags1);
+      read_semi_sorted_bucket(bucket2, tags2);
+      for (size_t slot = 0; slot < SLOTS_PER_BUCKET; slot++)
+        if (matches_tag(hash, tags1[slot]) || matches_tag(hash, tags2[slot]))
+          return true;
+      return false;
+    }
     for (size_t slot = 0; slot < SLOTS_PER_BUCKET; slot++)
       if (matches_tag(hash, read_tag(bucket1, slot)) || matches_tag(hash, read_tag(bucket2, slot)))
         return true;
@@ -236,6 +563,53 @@ public:
     return false;
   }
 
+  /**
+   * @brief Same as `match_hash_in_buckets`, but reads all slots of both buckets and combines the
+   * comparisons without branching, so that a miss does not pay for mispredicted early exits.
+   *
+   * @param bucket1 The index of the first bucket.
+   * @param bucket2 The index of the second bucket.
+   * @param hash The hash to match (must be a 32-bit uint hash).
+   * @return True if find a tag in any slot of one of the two buckets that
+   * matches the hash.
+   */
+  [[nodiscard]] auto match_hash_in_buckets_branchless(const size_t bucket1, const size_t bucket2,
+                                                      const uint32_t hash) const -> bool
+    requires ENABLE_FINGERPRINT_GROWTH
+  {
+    uint32_t tags1[SLOTS_PER_BUCKET];
+    uint32_t tags2[SLOTS_PER_BUCKET];
+    read_bucket(bucket1, tags1);
+    read_bucket(bucket2, tags2);
+    uint32_t found = 0;
+    for (size_t slot = 0; slot < SLOTS_PER_BUCKET; slot++)
+      found |= static_cast<uint32_t>(matches_tag_branchless(hash, tags1[slot])) |
+               static_cast<uint32_t>(matches_tag_branchless(hash, tags2[slot]));
+    return found != 0;
+  }
+
+  /**
+   * @brief Same as `find_tag_in_buckets`, but reads all slots of both buckets and combines the
+   * comparisons without branching, see `match_hash_in_buckets_branchless`.
+   *
+   * @param bucket1 The index of the first bucket.
+   * @param bucket2 The index of the second bucket.
+   * @param tag The tag to find.
+   * @return True if the tag exists in any slot of one of the two buckets.
+   */
+  [[nodiscard]] auto find_tag_in_buckets_branchless(const size_t bucket1, const size_t bucket2,
+                                                    const uint32_t tag) const -> bool {
+    uint32_t tags1[SLOTS_PER_BUCKET];
+    uint32_t tags2[SLOTS_PER_BUCKET];
+    read_bucket(bucket1, tags1);
+    read_bucket(bucket2, tags2);
+    uint32_t found = 0;
+    for (size_t slot = 0; slot < SLOTS_PER_BUCKET; slot++)
+      found |=
+          static_cast<uint32_t>(tags1[slot] == tag) | static_cast<uint32_t>(tags2[slot] == tag);
+    return found != 0;
+  }
+
   /**
    * @brief Find if any slot in the bucket contains the tag that matches the hash.
    *
@@ -244,6 +618,14 @@ public:
    * @return True if find a tag in any slot of the bucket that matches the hash.
    */
   [[nodiscard]] auto match_hash_in_bucket(const size_t bucket, const uint32_t hash) const -> bool {
+    if constexpr (SEMI_SORTED) {
+      uint32_t tags[SLOTS_PER_BUCKET];
+      read_semi_sorted_bucket(bucket, tags);
+      for (size_t slot = 0; slot < SLOTS_PER_BUCKET; slot++)
+        if (matches_tag(hash, tags[slot]))
+          return true;
+      return false;
+    }
     for (size_t slot = 0; slot < SLOTS_PER_BUCKET; slot++)
       if (matches_tag(hash, read_tag(bucket, slot)))
         return true;
@@ -257,6 +639,11 @@ public:
    * @return True if find a tag in any slot of the bucket.
    */
   [[nodiscard]] auto find_tag_in_bucket(const size_t bucket, const uint32_t tag) const -> bool {
+    if constexpr (SEMI_SORTED) {
+      uint32_t tags[SLOTS_PER_BUCKET];
+      read_semi_sorted_bucket(bucket, tags);
+      return std::find(tags, tags + SLOTS_PER_BUCKET, tag) != tags + SLOTS_PER_BUCKET;
+    }
     for (size_t slot = 0; slot < SLOTS_PER_BUCKET; slot++)
       if (read_tag(bucket, slot) == tag)
         return true;
@@ -395,31 +782,32 @@ public:
   }
 
   /**
-   * @brief Insert the tag to the bucket. If `kickout` is true, replace a random tag in the bucket
-   * if the bucket is full, and `old_tag` is the tag evicted.
+   * @brief Insert the tag to the first empty slot of the bucket. Tags are never evicted here, see
+   * `Segment::insert_tag` for making room.
    *
    * @param bucket The index of the bucket.
    * @param tag The tag to insert.
-   * @param kickout If true, replace a random tag in the bucket if the bucket is
-   * full.
-   * @param old_tag The tag evicted if the bucket is full.
-   * @return True if the tag is inserted successfully.
+   * @return True if the tag is inserted successfully, false if the bucket is full.
    */
-  auto insert_tag_to_bucket(const size_t bucket, const uint32_t tag, const bool kickout,
-                            uint32_t &old_tag) -> bool {
-    for (size_t slot = 0; slot < SLOTS_PER_BUCKET; slot++)
-      if (read_tag(bucket, slot) == 0) {
-        write_tag(bucket, slot, tag);
-        return true;
-      }
-
-    if (kickout) {
-      const size_t slot = std::rand() % SLOTS_PER_BUCKET;
-      old_tag = read_tag(bucket, slot);
-      write_tag(bucket, slot, tag);
-    }
+  auto insert_tag_to_bucket(const size_t bucket, const uint32_t tag) -> bool {
+    const size_t slot = find_empty_slot(bucket);
+    if (slot == SLOTS_PER_BUCKET)
+      return false;
+    write_tag(bucket, slot, tag);
+    return true;
+  }
 
-    return false;
+  /**
+   * @brief Find an empty slot in a bucket.
+   *
+   * @param bucket The index of the bucket.
+   * @return The index of the first empty slot, or `SLOTS_PER_BUCKET` if the bucket is full.
+   */
+  [[nodiscard]] auto find_empty_slot(const size_t bucket) const -> size_t {
+    for (size_t slot = 0; slot < SLOTS_PER_BUCKET; slot++)
+      if (read_tag(bucket, slot) == 0)
+        return slot;
+    return SLOTS_PER_BUCKET;
   }
 
   /**
@@ -429,6 +817,11 @@ public:
    * @return The number of tags in the bucket.
    */
   [[nodiscard]] auto count_tags_in_bucket(const size_t bucket) const -> size_t {
+    if constexpr (SEMI_SORTED) {
+      uint32_t tags[SLOTS_PER_BUCKET];
+      read_semi_sorted_bucket(bucket, tags);
+      return SLOTS_PER_BUCKET - std::count(tags, tags + SLOTS_PER_BUCKET, 0U);
+    }
     size_t count = 0;
     for (size_t slot = 0; slot < SLOTS_PER_BUCKET; slot++)
       if (read_tag(bucket, slot) != 0)
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Allocates the tag storage of segments outside the heap, see `DFF::DFF`. Memory is never
+ * given back, and is zero-filled.
+ */
+class Arena {
+public:
+  Arena() = default;
+  Arena(const Arena &) = delete;
+  Arena(Arena &&) = delete;
+  auto operator=(const Arena &) -> Arena & = delete;
+  auto operator=(Arena &&) -> Arena & = delete;
+  virtual ~Arena() = default;
+
+  // Allocations are aligned to cache lines
+  static constexpr size_t ALIGNMENT = 64;
+
+  /**
+   * @brief Allocate zero-filled memory.
+   *
+   * @param bytes Number of bytes to allocate.
+   * @return The allocated memory, or `nullptr` if the arena is exhausted.
+   */
+  virtual auto allocate(size_t bytes) -> uint8_t * = 0;
+};
+
+/**
+ * @brief A bump allocator over a fixed memory region, e.g., for segment tables in shared memory.
+ * The region must be zero-filled so that allocations are too.
+ */
+class FixedArena : public Arena {
+  uint8_t *base_;
+  size_t size_;
+  size_t used_ = 0;
+
+public:
+  /**
+   * @brief Create an arena over a memory region.
+   *
+   * @param base The region, aligned to `ALIGNMENT`.
+   * @param size Size of the region in bytes.
+   */
+  FixedArena(uint8_t *base, const size_t size) : base_(base), size_(size) {}
+
+  auto allocate(const size_t bytes) -> uint8_t * override {
+    const size_t aligned = (bytes + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    if (aligned > size_ - used_)
+      return nullptr;
+    uint8_t *res = base_ + used_;
+    used_ += aligned;
+    return res;
+  }
+
+  /**
+   * @brief Get the offset of allocated memory from the start of the region.
+   *
+   * @param ptr Memory allocated by `allocate`.
+   * @return The offset in bytes.
+   */
+  [[nodiscard]] auto offset_of(const uint8_t *ptr) const -> size_t {
+    return static_cast<size_t>(ptr - base_);
+  }
+
+  /**
+   * @brief Get the number of bytes allocated.
+   *
+   * @return The number of bytes.
+   */
+  [[nodiscard]] auto used() const -> size_t { return used_; }
+};
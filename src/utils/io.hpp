@@ -0,0 +1,201 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <streambuf>
+#include <type_traits>
+#include <vector>
+
+template <typename T>
+concept TriviallyCopyable = std::is_trivially_copyable_v<T>;
+
+/**
+ * @brief Write raw bytes to a stream.
+ *
+ * @param os The stream to write to.
+ * @param data The bytes to write.
+ * @param size Number of bytes to write.
+ * @return True if all bytes are written.
+ */
+inline auto write_bytes(std::ostream &os, const void *data, const size_t size) -> bool {
+  os.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+  return !os.fail();
+}
+
+/**
+ * @brief Read raw bytes from a stream.
+ *
+ * @param is The stream to read from.
+ * @param data The buffer to read into.
+ * @param size Number of bytes to read.
+ * @return True if all bytes are read.
+ */
+inline auto read_bytes(std::istream &is, void *data, const size_t size) -> bool {
+  is.read(static_cast<char *>(data), static_cast<std::streamsize>(size));
+  return !is.fail();
+}
+
+/**
+ * @brief Write a value to a stream in the native byte order.
+ *
+ * @param os The stream to write to.
+ * @param value The value to write.
+ * @return True if the value is written.
+ */
+template <TriviallyCopyable T> auto write_pod(std::ostream &os, const T &value) -> bool {
+  return write_bytes(os, &value, sizeof(T));
+}
+
+/**
+ * @brief Read a value written by `write_pod` from a stream.
+ *
+ * @param is The stream to read from.
+ * @param value The value read.
+ * @return True if the value is read.
+ */
+template <TriviallyCopyable T> auto read_pod(std::istream &is, T &value) -> bool {
+  return read_bytes(is, &value, sizeof(T));
+}
+
+/**
+ * @brief A read-only stream buffer over a memory region, so that data in memory (e.g., a memory
+ * mapped file) can be parsed by the same code as a file. Seeking does not touch the skipped bytes.
+ */
+class MemoryStreamBuffer : public std::streambuf {
+public:
+  MemoryStreamBuffer(const char *data, const size_t size) {
+    // `std::streambuf` requires non-const pointers, but nothing is written through them
+    auto *begin = const_cast<char *>(data);
+    setg(begin, begin, begin + size);
+  }
+
+protected:
+  auto seekoff(const off_type off, const std::ios_base::seekdir dir,
+               const std::ios_base::openmode /* which */) -> pos_type override {
+    char *base = dir == std::ios_base::beg ? eback() : dir == std::ios_base::cur ? gptr() : egptr();
+    if (off < eback() - base || off > egptr() - base)
+      return pos_type(off_type(-1));
+    setg(eback(), base + off, egptr());
+    return gptr() - eback();
+  }
+
+  auto seekpos(const pos_type pos, const std::ios_base::openmode which) -> pos_type override {
+    return seekoff(off_type(pos), std::ios_base::beg, which);
+  }
+};
+
+/**
+ * @brief Append values of any bit length to a byte buffer, packed least significant bit first.
+ * The last byte is padded with zeros by `flush`.
+ */
+class BitWriter {
+  std::vector<uint8_t> &bytes_;
+  uint64_t buffer_ = 0;
+  // Number of bits in `buffer_`
+  size_t num_bits_ = 0;
+
+public:
+  explicit BitWriter(std::vector<uint8_t> &bytes) : bytes_(bytes) {}
+
+  /**
+   * @brief Write the lowest bits of a value.
+   *
+   * @param value The value to write.
+   * @param length Number of bits to write, at most 32.
+   */
+  void write(const uint32_t value, const size_t length) {
+    buffer_ |= (value & ((uint64_t{1} << length) - 1)) << num_bits_;
+    num_bits_ += length;
+    for (; num_bits_ >= 8; num_bits_ -= 8, buffer_ >>= 8)
+      bytes_.push_back(static_cast<uint8_t>(buffer_));
+  }
+
+  /**
+   * @brief Write a value in unary code: `value` one bits followed by a zero bit. Cheap for values
+   * that are usually 0 or 1.
+   *
+   * @param value The value to write.
+   */
+  void write_unary(size_t value) {
+    for (; value >= 31; value -= 31)
+      write((uint32_t{1} << 31) - 1, 31);
+    write((uint32_t{1} << value) - 1, value + 1);
+  }
+
+  /**
+   * @brief Write the remaining bits, padded with zeros to a byte.
+   */
+  void flush() {
+    if (num_bits_ != 0)
+      bytes_.push_back(static_cast<uint8_t>(buffer_));
+    buffer_ = 0;
+    num_bits_ = 0;
+  }
+};
+
+/**
+ * @brief Read values written by `BitWriter` from a byte buffer.
+ */
+class BitReader {
+  const uint8_t *data_;
+  const uint8_t *end_;
+  uint64_t buffer_ = 0;
+  // Number of bits in `buffer_`
+  size_t num_bits_ = 0;
+
+  // Read bytes until the buffer holds at least `length` bits (at most 57)
+  auto fill(const size_t length) -> bool {
+    for (; num_bits_ <= 56 && data_ != end_; num_bits_ += 8)
+      buffer_ |= static_cast<uint64_t>(*data_++) << num_bits_;
+    return num_bits_ >= length;
+  }
+
+public:
+  BitReader(const uint8_t *data, const size_t size) : data_(data), end_(data + size) {}
+
+  /**
+   * @brief Read a value written by `BitWriter::write`.
+   *
+   * @param length Number of bits to read, at most 32.
+   * @param value The value read.
+   * @return True if the value is read.
+   */
+  auto read(const size_t length, uint32_t &value) -> bool {
+    if (num_bits_ < length && !fill(length))
+      return false;
+    value = static_cast<uint32_t>(buffer_ & ((uint64_t{1} << length) - 1));
+    buffer_ >>= length;
+    num_bits_ -= length;
+    return true;
+  }
+
+  /**
+   * @brief Read a value written by `BitWriter::write_unary`.
+   *
+   * @param max The largest valid value, so that malformed data is not read on and on.
+   * @param value The value read.
+   * @return True if a value of at most `max` is read.
+   */
+  auto read_unary(const size_t max, size_t &value) -> bool {
+    value = 0;
+    while (value <= max) {
+      if (num_bits_ == 0 && !fill(1))
+        return false;
+      // Bits beyond `num_bits_` are zero, so the count stops there at the latest
+      const auto ones = static_cast<size_t>(std::countr_one(buffer_));
+      if (ones < num_bits_) {
+        value += ones;
+        buffer_ >>= ones + 1;
+        num_bits_ -= ones + 1;
+        return value <= max;
+      }
+      value += num_bits_;
+      buffer_ = 0;
+      num_bits_ = 0;
+    }
+    return false;
+  }
+};
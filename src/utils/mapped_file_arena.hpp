@@ -0,0 +1,156 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "arena.hpp"
+
+/**
+ * @brief An arena backed by a file that grows as memory is allocated, so that segment tables can
+ * exceed the physical memory: the kernel pages tables in when they are touched and writes them
+ * back to the file under memory pressure, instead of swapping. The file is extended with
+ * `ftruncate` and mapped chunk by chunk, so existing allocations never move.
+ *
+ * Only the tables are in the file: the filter keeps its lookup table and, per segment, a header of
+ * a few hundred bytes (`sizeof(Segment)`, with its stash) on the heap.
+ *
+ * The file is scratch space: its content is not a saved filter (see `DFF::save`). Only available
+ * on POSIX platforms.
+ */
+class MappedFileArena : public Arena {
+  struct Mapping {
+    uint8_t *addr;
+    size_t size;
+  };
+
+  int fd_ = -1;
+  size_t chunk_size_;
+  size_t file_size_ = 0;
+  std::vector<Mapping> mappings_;
+  // Bytes allocated from the last mapping
+  size_t used_ = 0;
+
+public:
+  /**
+   * @brief Create an arena, see `open`.
+   *
+   * @param chunk_size Number of bytes the file grows by at least when an allocation does not fit,
+   * rounded up to pages. Larger chunks mean fewer mappings, but the unused end of a chunk is
+   * wasted when a larger allocation does not fit.
+   */
+  explicit MappedFileArena(const size_t chunk_size = 64UZ << 20) : chunk_size_(chunk_size) {}
+
+  ~MappedFileArena() override { close(); }
+
+  /**
+   * @brief Create the file backing the arena, truncating it if it exists.
+   *
+   * @param path Path of the file.
+   * @return True if the file is created.
+   */
+  auto open(const std::string &path) -> bool {
+#if defined(__unix__) || defined(__APPLE__)
+    close();
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    return fd_ >= 0;
+#else
+    return false;
+#endif
+  }
+
+  /**
+   * @brief Unmap the file, invalidating all allocations, and close it. The file is kept.
+   */
+  void close() {
+#if defined(__unix__) || defined(__APPLE__)
+    for (const Mapping &mapping : mappings_)
+      ::munmap(mapping.addr, mapping.size);
+    mappings_.clear();
+    if (fd_ >= 0)
+      ::close(fd_);
+    fd_ = -1;
+    file_size_ = 0;
+    used_ = 0;
+#endif
+  }
+
+  auto allocate(const size_t bytes) -> uint8_t * override {
+#if defined(__unix__) || defined(__APPLE__)
+    const size_t aligned = (bytes + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    if (mappings_.empty() || aligned > mappings_.back().size - used_) {
+      if (fd_ < 0)
+        return nullptr;
+      const auto page_size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+      const size_t grow = (std::max(aligned, chunk_size_) + page_size - 1) / page_size * page_size;
+      // The new part of the file reads as zeros
+      if (::ftruncate(fd_, static_cast<off_t>(file_size_ + grow)) != 0)
+        return nullptr;
+      void *addr = ::mmap(nullptr, grow, PROT_READ | PROT_WRITE, MAP_SHARED, fd_,
+                          static_cast<off_t>(file_size_));
+      if (addr == MAP_FAILED) {
+        // Give the space back, so that the file only holds mapped chunks
+        (void)::ftruncate(fd_, static_cast<off_t>(file_size_));
+        return nullptr;
+      }
+      mappings_.push_back({static_cast<uint8_t *>(addr), grow});
+      file_size_ += grow;
+      used_ = 0;
+    }
+    uint8_t *res = mappings_.back().addr + used_;
+    used_ += aligned;
+    return res;
+#else
+    return nullptr;
+#endif
+  }
+
+  /**
+   * @brief Hint the kernel that the allocated memory is not used soon, so that it is reclaimed
+   * before other memory under memory pressure. The memory stays valid. No-op where unsupported.
+   */
+  void advise_cold() const {
+#if defined(MADV_COLD)
+    for (const Mapping &mapping : mappings_)
+      ::madvise(mapping.addr, mapping.size, MADV_COLD);
+#endif
+  }
+
+  /**
+   * @brief Write the allocated memory back to the file and drop it from memory, so that it is read
+   * from the file again when touched. The memory stays valid.
+   *
+   * @return True if the memory is written back.
+   */
+  auto evict() const -> bool {
+#if defined(__unix__) || defined(__APPLE__)
+    for (const Mapping &mapping : mappings_) {
+      if (::msync(mapping.addr, mapping.size, MS_SYNC) != 0)
+        return false;
+      ::madvise(mapping.addr, mapping.size, MADV_DONTNEED);
+    }
+#if defined(POSIX_FADV_DONTNEED)
+    // Unmapped file pages stay in the page cache until dropped
+    ::posix_fadvise(fd_, 0, static_cast<off_t>(file_size_), POSIX_FADV_DONTNEED);
+#endif
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  /**
+   * @brief Get the size of the file backing the arena.
+   *
+   * @return The size in bytes.
+   */
+  [[nodiscard]] auto file_size() const -> size_t { return file_size_; }
+};
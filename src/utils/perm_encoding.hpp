@@ -0,0 +1,52 @@
+/*
+ * Modified from Cuckoo Filter implementation
+ * https://github.com/efficient/cuckoofilter/blob/master/src/permencoding.h
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Number of sorted sequences of 4 nibbles, C(16 + 4 - 1, 4)
+constexpr size_t NUM_NIBBLE_CODES = 3876;
+
+/**
+ * @brief Encode a sorted sequence of 4 nibbles in 12 bits, as its rank in the combinatorial number
+ * system (`C(n0, 1) + C(n1 + 1, 2) + C(n2 + 2, 3) + C(n3 + 3, 4)`), so that no table is needed.
+ *
+ * @param n0 The smallest nibble.
+ * @param n1 The second smallest nibble.
+ * @param n2 The third smallest nibble.
+ * @param n3 The largest nibble.
+ * @return The code, less than `NUM_NIBBLE_CODES`.
+ */
+constexpr auto encode_nibbles(const uint32_t n0, const uint32_t n1, const uint32_t n2,
+                              const uint32_t n3) -> uint32_t {
+  return n0 + (n1 + 1) * n1 / 2 + (n2 + 2) * (n2 + 1) * n2 / 6 +
+         (n3 + 3) * (n3 + 2) * (n3 + 1) * n3 / 24;
+}
+
+// The sorted sequence of 4 nibbles of each 12-bit code, the smallest in the lowest 4 bits. Codes
+// not written by `encode_nibbles` (e.g., in a corrupted file) decode to 0
+inline constexpr std::array<uint16_t, 1UZ << 12> NIBBLE_DECODE_TABLE = [] {
+  std::array<uint16_t, 1UZ << 12> table{};
+  for (uint32_t n3 = 0; n3 < 16; n3++)
+    for (uint32_t n2 = 0; n2 <= n3; n2++)
+      for (uint32_t n1 = 0; n1 <= n2; n1++)
+        for (uint32_t n0 = 0; n0 <= n1; n0++)
+          table[encode_nibbles(n0, n1, n2, n3)] =
+              static_cast<uint16_t>(n0 | (n1 << 4) | (n2 << 8) | (n3 << 12));
+  return table;
+}();
+
+/**
+ * @brief Decode a code written by `encode_nibbles`.
+ *
+ * @param code The code, a 12-bit integer.
+ * @return The 4 nibbles, the smallest in the lowest 4 bits.
+ */
+constexpr auto decode_nibbles(const uint32_t code) -> uint32_t {
+  return NIBBLE_DECODE_TABLE[code & 0xfff];
+}
@@ -0,0 +1,1242 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <catch2/catch_template_test_macros.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/DFF.hpp"
+#include "../src/predefine.hpp"
+
+constexpr size_t INSERT_NUM = 300'000;
+
+// generate the integers
+inline void random_gen(size_t n, uint64_t *store) {
+  std::mt19937 rd(12821);
+  const auto rand_range = static_cast<uint64_t>(std::pow(2, 64) / static_cast<double>(n));
+  for (size_t i = 0; i < n; i++) {
+    uint64_t rand = rand_range * i + rd() % rand_range;
+    store[i] = rand;
+  }
+}
+
+// Insert the first `INSERT_NUM` of the `2 * INSERT_NUM` integers into the filter and check that
+// they are all found. Returns the false positive rate measured with the others.
+template <typename Filter> auto insert_all(Filter &filter, const uint64_t *nums) -> double {
+  for (size_t i = 0; i < INSERT_NUM; i++)
+    REQUIRE(filter.insert(nums[i]) == dff::Ok);
+  for (size_t i = 0; i < INSERT_NUM; i++)
+    REQUIRE(filter.query(nums[i]) == dff::Ok);
+  size_t false_positive_count = 0;
+  for (size_t i = INSERT_NUM; i < INSERT_NUM * 2; i++)
+    if (filter.query(nums[i]) == dff::Ok)
+      false_positive_count++;
+  return static_cast<double>(false_positive_count) / INSERT_NUM;
+}
+
+// Remove every other integer inserted by `insert_all`, and check that the others are still found
+template <typename Filter> void remove_half(Filter &filter, const uint64_t *nums) {
+  for (size_t i = 0; i < INSERT_NUM; i += 2)
+    REQUIRE(filter.remove(nums[i]) == dff::Ok);
+  for (size_t i = 1; i < INSERT_NUM; i += 2)
+    REQUIRE(filter.query(nums[i]) == dff::Ok);
+}
+
+TEMPLATE_TEST_CASE("DFF should perform insertions/query/deletion correctly", "[dff]",
+                   (dff::DFF<uint64_t, false>), (dff::DFF<uint64_t, true>)) {
+  constexpr size_t GENERATE_NUM = INSERT_NUM * 2;
+  auto *nums = new uint64_t[GENERATE_NUM];
+  random_gen(GENERATE_NUM, nums);
+
+  // Insert
+  TestType filter(16);
+  for (size_t i = 0; i < INSERT_NUM; i++)
+    REQUIRE(filter.insert(nums[i]) == dff::Ok);
+
+  SECTION("No false negative should be found after insertion") {
+    for (size_t i = 0; i < INSERT_NUM; i++)
+      REQUIRE(filter.query(nums[i]) == dff::Ok);
+  }
+
+  SECTION("Should have some false positive, but not too many") {
+    size_t false_positive = 0;
+    for (size_t i = 0; i < INSERT_NUM; i++)
+      if (filter.query(nums[INSERT_NUM + i]) == dff::Ok)
+        false_positive++;
+    REQUIRE(false_positive > 0);
+    REQUIRE(static_cast<double>(false_positive) / static_cast<double>(INSERT_NUM) < 0.01);
+  }
+
+  SECTION("Deletion should work correctly") {
+    for (size_t i = 0; i < INSERT_NUM; i++)
+      REQUIRE(filter.remove(nums[i]) == dff::Ok);
+
+    // Should have 0 false positive since we deleted all the inserted elements
+    size_t false_positive = 0;
+    for (size_t i = 0; i < INSERT_NUM; i++)
+      if (filter.query(nums[i]) == dff::Ok)
+        false_positive++;
+    REQUIRE(false_positive == 0);
+  }
+
+  SECTION("Compaction should merge segments back without false negatives") {
+    const size_t num_seg_before = filter.num_seg;
+    REQUIRE(num_seg_before > dff::INITIAL_SEG_COUNT);
+
+    // Remove 90% of the items
+    constexpr size_t KEEP_NUM = INSERT_NUM / 10;
+    for (size_t i = KEEP_NUM; i < INSERT_NUM; i++)
+      REQUIRE(filter.remove(nums[i]) == dff::Ok);
+
+    REQUIRE(filter.compact() == dff::Ok);
+    REQUIRE(filter.num_seg < num_seg_before);
+    for (size_t i = 0; i < KEEP_NUM; i++)
+      REQUIRE(filter.query(nums[i]) == dff::Ok);
+
+    // Should be able to expand again after compaction
+    for (size_t i = KEEP_NUM; i < INSERT_NUM; i++)
+      REQUIRE(filter.insert(nums[i]) == dff::Ok);
+    for (size_t i = 0; i < INSERT_NUM; i++)
+      REQUIRE(filter.query(nums[i]) == dff::Ok);
+
+    // Removing everything should shrink the filter to its initial segments
+    for (size_t i = 0; i < INSERT_NUM; i++)
+      REQUIRE(filter.remove(nums[i]) == dff::Ok);
+    REQUIRE(filter.compact() == dff::Ok);
+    REQUIRE(filter.num_seg == dff::INITIAL_SEG_COUNT);
+    for (const size_t e : filter.max_expansion)
+      REQUIRE(e == 0);
+  }
+
+  SECTION("Automatic shrinking should merge segments on deletion") {
+    const size_t num_seg_before = filter.num_seg;
+    REQUIRE(filter.set_shrink_autonomously(true, 0.6) == dff::NotSupported);
+    REQUIRE(filter.set_shrink_autonomously(true) == dff::Ok);
+
+    constexpr size_t KEEP_NUM = INSERT_NUM / 10;
+    for (size_t i = KEEP_NUM; i < INSERT_NUM; i++)
+      REQUIRE(filter.remove(nums[i]) == dff::Ok);
+    REQUIRE(filter.num_seg < num_seg_before);
+    for (size_t i = 0; i < KEEP_NUM; i++)
+      REQUIRE(filter.query(nums[i]) == dff::Ok);
+
+    // Oscillating load should not lose any item
+    for (size_t round = 0; round < 3; round++) {
+      for (size_t i = KEEP_NUM; i < INSERT_NUM; i++)
+        REQUIRE(filter.insert(nums[i]) == dff::Ok);
+      for (size_t i = KEEP_NUM; i < INSERT_NUM; i++)
+        REQUIRE(filter.remove(nums[i]) == dff::Ok);
+    }
+    for (size_t i = 0; i < KEEP_NUM; i++)
+      REQUIRE(filter.query(nums[i]) == dff::Ok);
+  }
+
+  delete[] nums;
+}
+
+TEMPLATE_TEST_CASE("Segment should move tags along short cuckoo paths at high load", "[dff]",
+                   (dff::Segment<uint64_t, false>), (dff::Segment<uint64_t, true>)) {
+  constexpr size_t FILL_NUM = dff::BUCKETS_PER_SEG * dff::SLOTS_PER_BUCKET * 95 / 100;
+  auto *nums = new uint64_t[FILL_NUM];
+  random_gen(FILL_NUM, nums);
+
+  const auto index = [&](const size_t i) { return nums[i] & (dff::BUCKETS_PER_SEG - 1); };
+  const auto hash = [&](const size_t i) { return static_cast<uint32_t>(nums[i] >> 32); };
+
+  TestType seg(dff::BUCKETS_PER_SEG, 16, 16);
+  for (size_t i = 0; i < FILL_NUM; i++) {
+    const uint64_t kicks = seg.num_kicks;
+    REQUIRE(seg.insert(index(i), hash(i)) == dff::Ok);
+    REQUIRE(seg.num_kicks - kicks <= dff::K_MAX_KICK_COUNT);
+  }
+  REQUIRE(seg.num_items == FILL_NUM);
+  REQUIRE(seg.num_kicks > 0);
+
+  // Moved tags are still found
+  for (size_t i = 0; i < FILL_NUM; i++)
+    REQUIRE(seg.query(index(i), hash(i)) == dff::Ok);
+
+  delete[] nums;
+}
+
+TEMPLATE_TEST_CASE("Segment should stash tags that cannot be placed", "[dff]",
+                   (dff::Segment<uint64_t, false>), (dff::Segment<uint64_t, true>)) {
+  constexpr size_t GENERATE_NUM = dff::BUCKETS_PER_SEG * dff::SLOTS_PER_BUCKET;
+  auto *nums = new uint64_t[GENERATE_NUM];
+  random_gen(GENERATE_NUM, nums);
+
+  const auto index = [&](const size_t i) { return nums[i] & (dff::BUCKETS_PER_SEG - 1); };
+  const auto hash = [&](const size_t i) { return static_cast<uint32_t>(nums[i] >> 32); };
+
+  // Insert until the stash is full
+  TestType seg(dff::BUCKETS_PER_SEG, 16, 16);
+  size_t inserted = 0;
+  while (seg.stash().size() < dff::STASH_SIZE) {
+    REQUIRE(inserted < GENERATE_NUM);
+    REQUIRE(seg.insert(index(inserted), hash(inserted)) == dff::Ok);
+    inserted++;
+  }
+  REQUIRE_FALSE(seg.saturated());
+  REQUIRE(seg.needs_expansion());
+
+  // Once the stash is full, an item that does not fit is left out without saturating the segment
+  while (seg.insert(index(inserted), hash(inserted)) == dff::Ok) {
+    inserted++;
+    REQUIRE(inserted < GENERATE_NUM);
+  }
+  REQUIRE_FALSE(seg.saturated());
+  REQUIRE(seg.stash().size() == dff::STASH_SIZE);
+
+  // Stashed tags are found and removed like the others
+  for (size_t i = 0; i < inserted; i++)
+    REQUIRE(seg.query(index(i), hash(i)) == dff::Ok);
+  for (size_t i = 0; i < inserted; i += 2)
+    REQUIRE(seg.remove(index(i), hash(i)) == dff::Ok);
+  REQUIRE(seg.stash().empty());
+  for (size_t i = 1; i < inserted; i += 2)
+    REQUIRE(seg.query(index(i), hash(i)) == dff::Ok);
+
+  delete[] nums;
+}
+
+TEMPLATE_TEST_CASE("DFF should degrade gracefully under a memory budget", "[dff]",
+                   (dff::DFF<uint64_t, false>), (dff::DFF<uint64_t, true>)) {
+  constexpr size_t GENERATE_NUM = INSERT_NUM * 2;
+  auto *nums = new uint64_t[GENERATE_NUM];
+  random_gen(GENERATE_NUM, nums);
+
+  TestType filter(16);
+  // Room for about 2 more segments
+  const size_t budget = filter.memory_usage() * 3 / 2;
+  filter.set_memory_budget(budget);
+
+  for (size_t i = 0; i < INSERT_NUM; i++)
+    REQUIRE(filter.insert(nums[i]) == dff::Ok);
+  REQUIRE(filter.memory_usage() <= budget);
+
+  // No false negative even if the filter is overloaded
+  for (size_t i = 0; i < INSERT_NUM; i++)
+    REQUIRE(filter.query(nums[i]) == dff::Ok);
+
+  size_t false_positive = 0;
+  for (size_t i = 0; i < INSERT_NUM; i++)
+    if (filter.query(nums[INSERT_NUM + i]) == dff::Ok)
+      false_positive++;
+  const double fpr = static_cast<double>(false_positive) / static_cast<double>(INSERT_NUM);
+  REQUIRE(fpr > filter.predicted_false_positive_rate() / 2);
+  REQUIRE(fpr < filter.predicted_false_positive_rate() * 2);
+
+  // Saturated segments recover once the items they lost are removed
+  const auto saturated_count = [&filter] {
+    size_t count = 0;
+    for (const auto *seg = filter.head; seg != nullptr; seg = seg->next)
+      count += seg->saturated() ? 1 : 0;
+    return count;
+  };
+  REQUIRE(saturated_count() > 0);
+  for (size_t i = 0; i < INSERT_NUM; i++)
+    filter.remove(nums[i]);
+  REQUIRE(saturated_count() == 0);
+  REQUIRE(filter.predicted_false_positive_rate() < 0.01);
+
+  delete[] nums;
+}
+
+TEMPLATE_TEST_CASE("DFF should not expand after reserving", "[dff]", (dff::DFF<uint64_t, false>),
+                   (dff::DFF<uint64_t, true>)) {
+  auto *nums = new uint64_t[INSERT_NUM];
+  random_gen(INSERT_NUM, nums);
+
+  TestType filter(16);
+  REQUIRE(filter.reserve(INSERT_NUM) == dff::Ok);
+  const size_t num_seg_reserved = filter.num_seg;
+  REQUIRE(num_seg_reserved > dff::INITIAL_SEG_COUNT);
+  for (const size_t e : filter.max_expansion)
+    REQUIRE(e == filter.max_expansion[0]);
+
+  // Reserving less than what is already reserved does nothing
+  REQUIRE(filter.reserve(INSERT_NUM / 2) == dff::Ok);
+  REQUIRE(filter.num_seg == num_seg_reserved);
+
+  for (size_t i = 0; i < INSERT_NUM; i++)
+    REQUIRE(filter.insert(nums[i]) == dff::Ok);
+  REQUIRE(filter.num_seg == num_seg_reserved);
+  for (size_t i = 0; i < INSERT_NUM; i++)
+    REQUIRE(filter.query(nums[i]) == dff::Ok);
+
+  // Reserving more splits the populated segments without losing items
+  REQUIRE(filter.reserve(INSERT_NUM * 4) == dff::Ok);
+  REQUIRE(filter.num_seg > num_seg_reserved);
+  for (size_t i = 0; i < INSERT_NUM; i++)
+    REQUIRE(filter.query(nums[i]) == dff::Ok);
+
+  // Just below the capacity of twice the initial segments, the fullest of them would still
+  // overflow
+  TestType boundary(16);
+  const auto boundary_num = static_cast<size_t>(
+      static_cast<double>(boundary.head->capacity * dff::INITIAL_SEG_COUNT * 2) * 0.995);
+  REQUIRE(boundary_num <= INSERT_NUM);
+  REQUIRE(boundary.reserve(boundary_num) == dff::Ok);
+  const size_t boundary_num_seg = boundary.num_seg;
+  for (size_t i = 0; i < boundary_num; i++)
+    REQUIRE(boundary.insert(nums[i]) == dff::Ok);
+  REQUIRE(boundary.num_seg == boundary_num_seg);
+
+  delete[] nums;
+}
+
+TEMPLATE_TEST_CASE("DFF should expand segments at the load threshold", "[dff]",
+                   (dff::DFF<uint64_t, false>), (dff::DFF<uint64_t, true>)) {
+  auto *nums = new uint64_t[INSERT_NUM];
+  random_gen(INSERT_NUM, nums);
+
+  TestType low(16);
+  // Same hash seed, so that the two only differ by the kick rate trigger
+  TestType high(16, 42);
+  TestType adaptive(16, 42);
+  REQUIRE(low.set_load_threshold(0.4) == dff::NotSupported);
+  REQUIRE(low.set_load_threshold(0.5) == dff::Ok);
+  REQUIRE(high.set_load_threshold(0.95) == dff::Ok);
+  REQUIRE(adaptive.set_adaptive_expansion(true, 0.0) == dff::NotSupported);
+  REQUIRE(adaptive.set_adaptive_expansion(true) == dff::Ok);
+
+  // Insert all items, and get the number of items inserted before the first expansion
+  const auto insert_all = [nums](TestType &filter) {
+    const size_t initial_num_seg = filter.num_seg;
+    size_t first_expansion = INSERT_NUM;
+    for (size_t i = 0; i < INSERT_NUM; i++) {
+      REQUIRE(filter.insert(nums[i]) == dff::Ok);
+      if (first_expansion == INSERT_NUM && filter.num_seg != initial_num_seg)
+        first_expansion = i;
+    }
+    for (size_t i = 0; i < INSERT_NUM; i++)
+      REQUIRE(filter.query(nums[i]) == dff::Ok);
+    for (const auto *seg = filter.head; seg != nullptr; seg = seg->next)
+      REQUIRE(seg->stash().empty());
+    return first_expansion;
+  };
+  const size_t low_first_expansion = insert_all(low);
+  const size_t high_first_expansion = insert_all(high);
+  const size_t adaptive_first_expansion = insert_all(adaptive);
+  REQUIRE(low.num_seg > high.num_seg);
+  REQUIRE(low.num_seg > adaptive.num_seg);
+  REQUIRE(low_first_expansion < high_first_expansion);
+  // Adaptive expansion has the capacity of the highest load threshold, but expands a segment
+  // before it reaches it once inserting into it kicks too many tags
+  REQUIRE(adaptive_first_expansion < high_first_expansion);
+
+  // Existing segments take the new threshold
+  REQUIRE(high.set_load_threshold(0.5) == dff::Ok);
+  for (const auto *seg = high.head; seg != nullptr; seg = seg->next)
+    REQUIRE(seg->capacity == low.head->capacity);
+
+  delete[] nums;
+}
+
+// The geometry of a filter type
+template <typename Filter> struct FilterTraits;
+template <typename T, bool FG, typename C> struct FilterTraits<dff::DFF<T, FG, C>> {
+  using Config = C;
+  using Table = dff::SingleTable<FG, C>;
+};
+
+TEMPLATE_TEST_CASE("DFF should work with other geometries", "[dff]",
+                   (dff::DFF<uint64_t, false, dff::Config<4096, 11, 8>>),
+                   (dff::DFF<uint64_t, true, dff::Config<8192, 16, 4, 1UZ << 18>>)) {
+  using Config = typename FilterTraits<TestType>::Config;
+  constexpr size_t GENERATE_NUM = INSERT_NUM * 2;
+  auto *nums = new uint64_t[GENERATE_NUM];
+  random_gen(GENERATE_NUM, nums);
+
+  // The initial segments share the lookup table evenly, each with a table of the geometry
+  TestType filter(16);
+  REQUIRE(filter.num_seg == Config::INITIAL_SEG_COUNT);
+  for (const auto *seg = filter.head; seg != nullptr; seg = seg->next) {
+    REQUIRE(seg->lut_slots_count == Config::INITIAL_LOOKUP_TABLE_ENTRIES_PER_SEG);
+    REQUIRE(seg->table->size_in_bytes() ==
+            FilterTraits<TestType>::Table::size_in_bytes(Config::BUCKETS_PER_SEG, 16));
+    REQUIRE(seg->capacity < Config::BUCKETS_PER_SEG * Config::SLOTS_PER_BUCKET);
+  }
+
+  REQUIRE(insert_all(filter, nums) < 0.01);
+  // Expanded segments still cover the whole lookup table, each with a run of slots
+  REQUIRE(filter.max_expansion[0] > 0);
+  size_t lut_slots_count = 0;
+  for (const auto *seg = filter.head; seg != nullptr; seg = seg->next) {
+    for (uint32_t i = 0; i < seg->lut_slots_count; i++)
+      REQUIRE(filter.lookup_table[seg->first_lut_slot + i] == seg);
+    lut_slots_count += seg->lut_slots_count;
+  }
+  REQUIRE(lut_slots_count == Config::LOOKUP_TABLE_SIZE);
+
+  // Saved filters only load with the same geometry
+  std::stringstream ss;
+  REQUIRE(filter.save(ss) == dff::Ok);
+  TestType loaded(16);
+  REQUIRE(loaded.load(ss) == dff::Ok);
+  std::stringstream default_ss(ss.str());
+  dff::DFF<uint64_t, false> default_geometry(16);
+  REQUIRE(default_geometry.load(default_ss) != dff::Ok);
+  remove_half(loaded, nums);
+
+  delete[] nums;
+}
+
+TEMPLATE_TEST_CASE("DFF should work with fixed bits per tag", "[dff]",
+                   (std::integral_constant<size_t, 8>), (std::integral_constant<size_t, 12>),
+                   (std::integral_constant<size_t, 16>), (std::integral_constant<size_t, 32>)) {
+  constexpr size_t BITS = TestType::value;
+  constexpr size_t GENERATE_NUM = INSERT_NUM * 2;
+  auto *nums = new uint64_t[GENERATE_NUM];
+  random_gen(GENERATE_NUM, nums);
+
+  // Tags are read and written as whole words (or through a 2-byte window for 12 bits) at the bit
+  // positions of the bit-packed table, without touching their neighbours
+  dff::SingleTable<false, dff::FixedTagConfig<BITS>> table(dff::BUCKETS_PER_SEG, BITS);
+  dff::SingleTable<false> packed(dff::BUCKETS_PER_SEG, BITS);
+  REQUIRE(table.size_in_bytes() == packed.size_in_bytes());
+  std::mt19937 rd(12821);
+  const uint32_t mask = BITS == 32 ? ~0U : (1U << BITS) - 1;
+  std::vector<uint32_t> tags(dff::BUCKETS_PER_SEG * dff::SLOTS_PER_BUCKET);
+  // Every tag, then every other one again
+  for (size_t pass = 0; pass < 2; pass++)
+    for (size_t i = pass; i < tags.size(); i += pass + 1) {
+      tags[i] = rd() & mask;
+      table.write_tag(i / dff::SLOTS_PER_BUCKET, i % dff::SLOTS_PER_BUCKET, tags[i]);
+      packed.write_tag(i / dff::SLOTS_PER_BUCKET, i % dff::SLOTS_PER_BUCKET, tags[i]);
+    }
+  for (size_t i = 0; i < tags.size(); i++)
+    REQUIRE(table.read_tag(i / dff::SLOTS_PER_BUCKET, i % dff::SLOTS_PER_BUCKET) == tags[i]);
+  REQUIRE(std::equal(table.data(), table.data() + table.size_in_bytes(), packed.data()));
+
+  // The bits per item given to the constructor are ignored
+  dff::DFF<uint64_t, false, dff::FixedTagConfig<BITS>> filter(BITS + 1, 42);
+  dff::DFF<uint64_t, false> runtime_filter(BITS, 42);
+  REQUIRE(insert_all(filter, nums) == insert_all(runtime_filter, nums));
+
+  // Tags are laid out as with the bits per tag given at runtime
+  std::stringstream ss;
+  std::stringstream runtime_ss;
+  REQUIRE(filter.save(ss) == dff::Ok);
+  REQUIRE(runtime_filter.save(runtime_ss) == dff::Ok);
+  REQUIRE(ss.str() == runtime_ss.str());
+  dff::DFF<uint64_t, false, dff::FixedTagConfig<BITS>> loaded(BITS);
+  REQUIRE(loaded.load(runtime_ss) == dff::Ok);
+  dff::DFF<uint64_t, false> other_bits(BITS == 8 ? 16 : 8);
+  std::stringstream other_ss;
+  REQUIRE(other_bits.save(other_ss) == dff::Ok);
+  REQUIRE(loaded.load(other_ss) == dff::NotSupported);
+  remove_half(loaded, nums);
+
+  delete[] nums;
+}
+
+TEMPLATE_TEST_CASE("DFF should work with blocked alternative buckets", "[dff]", std::false_type,
+                   std::true_type) {
+  // Cache line blocks without fingerprint growth, page blocks with it
+  constexpr bool FG = TestType::value;
+  constexpr size_t BLOCK_BUCKETS = FG ? 512 : 8;
+  using Filter = dff::DFF<uint64_t, FG, dff::BlockedConfig<BLOCK_BUCKETS>>;
+  using Segment = dff::Segment<uint64_t, FG, dff::BlockedConfig<BLOCK_BUCKETS>>;
+  constexpr size_t GENERATE_NUM = INSERT_NUM * 2;
+  auto *nums = new uint64_t[GENERATE_NUM];
+  random_gen(GENERATE_NUM, nums);
+
+  // The two buckets of a tag differ and are in the same aligned block, from either of them and
+  // however many bits the alternative index drops from the tag
+  std::mt19937 rd(12821);
+  for (size_t i = 0; i < INSERT_NUM; i++) {
+    const size_t index = rd() % dff::BUCKETS_PER_SEG;
+    const uint32_t tag = rd() | 1;
+    for (const size_t bits_to_shift : {0UZ, 8UZ, 16UZ}) {
+      const size_t alt = Segment::alt_index(index, tag, bits_to_shift);
+      REQUIRE(alt != index);
+      REQUIRE((alt ^ index) < BLOCK_BUCKETS);
+      REQUIRE(Segment::alt_index(alt, tag, bits_to_shift) == index);
+    }
+  }
+
+  Filter filter(16);
+  REQUIRE(insert_all(filter, nums) < 0.01);
+
+  // Tags are placed differently, so the filter only loads with the same blocks
+  std::stringstream ss;
+  REQUIRE(filter.save(ss) == dff::Ok);
+  std::stringstream default_ss(ss.str());
+  Filter loaded(16);
+  REQUIRE(loaded.load(ss) == dff::Ok);
+  dff::DFF<uint64_t, FG> default_blocks(16);
+  REQUIRE(default_blocks.load(default_ss) == dff::NotSupported);
+  remove_half(loaded, nums);
+
+  delete[] nums;
+}
+
+TEST_CASE("Nibble codes should decode to the encoded nibbles", "[dff]") {
+  for (uint32_t n3 = 0; n3 < 16; n3++)
+    for (uint32_t n2 = 0; n2 <= n3; n2++)
+      for (uint32_t n1 = 0; n1 <= n2; n1++)
+        for (uint32_t n0 = 0; n0 <= n1; n0++) {
+          const uint32_t code = encode_nibbles(n0, n1, n2, n3);
+          REQUIRE(code < NUM_NIBBLE_CODES);
+          REQUIRE(decode_nibbles(code) == (n0 | (n1 << 4) | (n2 << 8) | (n3 << 12)));
+        }
+}
+
+TEMPLATE_TEST_CASE("DFF should work with semi-sorted buckets", "[dff]", std::false_type,
+                   std::true_type) {
+  constexpr bool FG = TestType::value;
+  constexpr size_t GENERATE_NUM = INSERT_NUM * 2;
+  auto *nums = new uint64_t[GENERATE_NUM];
+  random_gen(GENERATE_NUM, nums);
+
+  // A bucket keeps its tags, sorted by their low 4 bits, in 4 bits less than they take, without
+  // touching the neighbouring buckets
+  using Table = dff::SingleTable<FG, dff::SemiSortedConfig>;
+  REQUIRE(Table::size_in_bytes(dff::BUCKETS_PER_SEG, 16) ==
+          dff::SingleTable<FG>::size_in_bytes(dff::BUCKETS_PER_SEG, 16) -
+              dff::BUCKETS_PER_SEG * 4 / 8);
+  Table table(dff::BUCKETS_PER_SEG, 16);
+  std::mt19937 rd(12821);
+  constexpr uint32_t TAG_MASK = (1U << (FG ? 17 : 16)) - 1;
+  std::vector<std::array<uint32_t, dff::SLOTS_PER_BUCKET>> buckets(dff::BUCKETS_PER_SEG);
+  // Every bucket, then every other one again
+  for (size_t pass = 0; pass < 2; pass++)
+    for (size_t bucket = pass; bucket < dff::BUCKETS_PER_SEG; bucket += pass + 1) {
+      uint32_t tags[dff::SLOTS_PER_BUCKET];
+      for (uint32_t &tag : tags)
+        // Some empty slots and few distinct low bits, so that they repeat in a bucket
+        tag = rd() % 4 == 0 ? 0 : ((rd() & TAG_MASK & ~0xfU) | (rd() % 3));
+      table.write_bucket(bucket, tags);
+      std::ranges::copy(tags, buckets[bucket].begin());
+    }
+  for (size_t bucket = 0; bucket < dff::BUCKETS_PER_SEG; bucket++) {
+    uint32_t tags[dff::SLOTS_PER_BUCKET];
+    table.read_bucket(bucket, tags);
+    REQUIRE(std::ranges::is_sorted(tags, {}, [](const uint32_t tag) { return tag & 0xf; }));
+    std::ranges::sort(tags);
+    std::ranges::sort(buckets[bucket]);
+    REQUIRE(std::ranges::equal(tags, buckets[bucket]));
+  }
+
+  dff::SemiSortedDFF<uint64_t, FG> filter(16, 42);
+  dff::DFF<uint64_t, FG> plain_filter(16, 42);
+  REQUIRE(insert_all(filter, nums) < 0.01);
+  insert_all(plain_filter, nums);
+
+  // One bit less per tag, with segments expanded at the same loads
+  REQUIRE(filter.num_seg == plain_filter.num_seg);
+  REQUIRE(filter.memory_usage() < plain_filter.memory_usage());
+
+  // Saved tables are encoded, exported tags are not
+  std::stringstream ss;
+  REQUIRE(filter.save(ss) == dff::Ok);
+  REQUIRE(plain_filter.load(ss) == dff::NotSupported);
+  std::stringstream tags_ss;
+  REQUIRE(filter.export_tags(tags_ss) == dff::Ok);
+  REQUIRE(plain_filter.import_tags(tags_ss) == dff::Ok);
+  for (size_t i = 0; i < INSERT_NUM; i++)
+    REQUIRE(plain_filter.query(nums[i]) == dff::Ok);
+  dff::SemiSortedDFF<uint64_t, FG> loaded(16);
+  ss.seekg(0);
+  REQUIRE(loaded.load(ss) == dff::Ok);
+  remove_half(loaded, nums);
+
+  delete[] nums;
+}
+
+TEMPLATE_TEST_CASE("DFF should give the same answers with every query strategy", "[dff]",
+                   (std::integral_constant<dff::QueryStrategy, dff::QueryStrategy::PrimaryFirst>),
+                   (std::integral_constant<dff::QueryStrategy, dff::QueryStrategy::Branchless>)) {
+  constexpr dff::QueryStrategy STRATEGY = TestType::value;
+  constexpr size_t GENERATE_NUM = INSERT_NUM * 2;
+  auto *nums = new uint64_t[GENERATE_NUM];
+  random_gen(GENERATE_NUM, nums);
+
+  const auto check = [&]<bool FG>() {
+    // The branchless bucket scans find the same tags as the early exiting ones
+    dff::SingleTable<FG> table(dff::BUCKETS_PER_SEG, 8);
+    std::mt19937 rd(12821);
+    std::vector<std::pair<size_t, uint32_t>> stored;
+    for (size_t bucket = 0; bucket < dff::BUCKETS_PER_SEG; bucket++)
+      for (size_t slot = 0; slot < dff::SLOTS_PER_BUCKET; slot++)
+        if (rd() % 4 != 0) {
+          const uint32_t hash = rd();
+          table.write_tag(bucket, slot, table.gen_tag(hash));
+          stored.emplace_back(bucket, hash);
+        }
+    const auto scans_agree = [&table](const size_t bucket1, const size_t bucket2,
+                                      const uint32_t hash) {
+      bool found;
+      if constexpr (FG) {
+        found = table.match_hash_in_buckets(bucket1, bucket2, hash);
+        REQUIRE(table.match_hash_in_buckets_branchless(bucket1, bucket2, hash) == found);
+      } else {
+        const uint32_t tag = table.gen_tag(hash);
+        found = table.find_tag_in_buckets(bucket1, bucket2, tag);
+        REQUIRE(table.find_tag_in_buckets_branchless(bucket1, bucket2, tag) == found);
+      }
+      return found;
+    };
+    for (const auto &[bucket, hash] : stored) {
+      const size_t other_bucket = rd() % dff::BUCKETS_PER_SEG;
+      REQUIRE(scans_agree(bucket, other_bucket, hash));
+      REQUIRE(scans_agree(other_bucket, bucket, hash));
+      scans_agree(bucket, other_bucket, static_cast<uint32_t>(rd()));
+    }
+
+    dff::DFF<uint64_t, FG, dff::QueryConfig<STRATEGY>> filter(16, 42);
+    dff::DFF<uint64_t, FG> interleaved(16, 42);
+    insert_all(filter, nums);
+    insert_all(interleaved, nums);
+    for (size_t i = INSERT_NUM; i < GENERATE_NUM; i++)
+      REQUIRE(filter.query(nums[i]) == interleaved.query(nums[i]));
+
+    // Tags are placed the same way, so files are shared
+    std::stringstream ss;
+    REQUIRE(filter.save(ss) == dff::Ok);
+    REQUIRE(interleaved.load(ss) == dff::Ok);
+    remove_half(filter, nums);
+  };
+  check.template operator()<false>();
+  check.template operator()<true>();
+
+  delete[] nums;
+}
+
+TEMPLATE_TEST_CASE("DFF should work with two-choice insertions", "[dff]", std::false_type,
+                   std::true_type) {
+  constexpr bool FG = TestType::value;
+  using Segment = dff::Segment<uint64_t, FG, dff::TwoChoiceConfig>;
+  constexpr size_t GENERATE_NUM = INSERT_NUM * 2;
+  auto *nums = new uint64_t[GENERATE_NUM];
+  random_gen(GENERATE_NUM, nums);
+
+  // Copies of a tag go to the less loaded of its two buckets, not to the first one with room
+  constexpr uint32_t HASH = 0x9e3779b9;
+  Segment seg(dff::BUCKETS_PER_SEG, 16, 16);
+  dff::Segment<uint64_t, FG> first_choice_seg(dff::BUCKETS_PER_SEG, 16, 16);
+  for (size_t i = 0; i < dff::SLOTS_PER_BUCKET; i++) {
+    REQUIRE(seg.insert(0, HASH) == dff::Ok);
+    REQUIRE(first_choice_seg.insert(0, HASH) == dff::Ok);
+  }
+  const size_t alt =
+      Segment::alt_index(0, seg.table->gen_tag(HASH), seg.k_bits_to_shift_used_by_alt_index);
+  REQUIRE(seg.table->count_tags_in_bucket(0) == dff::SLOTS_PER_BUCKET / 2);
+  REQUIRE(seg.table->count_tags_in_bucket(alt) == dff::SLOTS_PER_BUCKET / 2);
+  REQUIRE(first_choice_seg.table->count_tags_in_bucket(0) == dff::SLOTS_PER_BUCKET);
+  REQUIRE(seg.num_kicks == 0);
+
+  dff::TwoChoiceDFF<uint64_t, FG> filter(16, 42);
+  dff::DFF<uint64_t, FG> first_choice(16, 42);
+  REQUIRE(insert_all(filter, nums) < 0.01);
+  insert_all(first_choice, nums);
+
+  // Buckets filled evenly need fewer kicks
+  const auto count_kicks = [](const auto &dff) {
+    uint64_t kicks = 0;
+    for (const auto *seg = dff.head; seg != nullptr; seg = seg->next)
+      kicks += seg->num_kicks;
+    return kicks;
+  };
+  REQUIRE(count_kicks(filter) < count_kicks(first_choice));
+
+  // Tags are found in either bucket, so files are shared
+  std::stringstream ss;
+  REQUIRE(filter.save(ss) == dff::Ok);
+  REQUIRE(first_choice.load(ss) == dff::Ok);
+  for (size_t i = 0; i < INSERT_NUM; i++)
+    REQUIRE(first_choice.query(nums[i]) == dff::Ok);
+  remove_half(filter, nums);
+
+  delete[] nums;
+}
+
+TEMPLATE_TEST_CASE("DFF should be cloned and moved correctly", "[dff]", (dff::DFF<uint64_t, false>),
+                   (dff::DFF<uint64_t, true>)) {
+  constexpr size_t GENERATE_NUM = INSERT_NUM * 2;
+  auto *nums = new uint64_t[GENERATE_NUM];
+  random_gen(GENERATE_NUM, nums);
+
+  TestType filter(16);
+  for (size_t i = 0; i < INSERT_NUM; i++)
+    REQUIRE(filter.insert(nums[i]) == dff::Ok);
+
+  SECTION("A clone should be independent of the original filter") {
+    TestType clone = filter.clone();
+    REQUIRE(clone.num_seg == filter.num_seg);
+    REQUIRE(clone.memory_usage() == filter.memory_usage());
+    for (size_t i = 0; i < INSERT_NUM; i++)
+      REQUIRE(clone.query(nums[i]) == dff::Ok);
+
+    // Same hash seed, so both answer negative queries the same way
+    for (size_t i = INSERT_NUM; i < GENERATE_NUM; i++)
+      REQUIRE(clone.query(nums[i]) == filter.query(nums[i]));
+
+    // Changing the clone does not change the original filter
+    for (size_t i = INSERT_NUM; i < GENERATE_NUM; i++)
+      REQUIRE(clone.insert(nums[i]) == dff::Ok);
+    for (size_t i = 0; i < INSERT_NUM; i++)
+      REQUIRE(clone.remove(nums[i]) == dff::Ok);
+    for (size_t i = 0; i < INSERT_NUM; i++)
+      REQUIRE(filter.query(nums[i]) == dff::Ok);
+
+    // Assigning a copy replaces the old segments
+    clone = filter;
+    REQUIRE(clone.num_seg == filter.num_seg);
+    for (size_t i = 0; i < INSERT_NUM; i++)
+      REQUIRE(clone.query(nums[i]) == dff::Ok);
+  }
+
+  SECTION("A moved filter should keep all items") {
+    const size_t num_seg = filter.num_seg;
+    TestType moved(std::move(filter));
+    REQUIRE(moved.num_seg == num_seg);
+    for (size_t i = 0; i < INSERT_NUM; i++)
+      REQUIRE(moved.query(nums[i]) == dff::Ok);
+
+    TestType assigned(16);
+    assigned = std::move(moved);
+    REQUIRE(assigned.num_seg == num_seg);
+    for (size_t i = 0; i < INSERT_NUM; i++)
+      REQUIRE(assigned.query(nums[i]) == dff::Ok);
+  }
+
+  delete[] nums;
+}
+
+TEMPLATE_TEST_CASE("DFF built with the same hash seed should be identical", "[dff]",
+                   (dff::DFF<uint64_t, false>), (dff::DFF<uint64_t, true>)) {
+  constexpr size_t GENERATE_NUM = INSERT_NUM * 2;
+  constexpr uint64_t HASH_SEED = 12821;
+  auto *nums = new uint64_t[GENERATE_NUM];
+  random_gen(GENERATE_NUM, nums);
+
+  TestType filter1(16, HASH_SEED);
+  TestType filter2(16, HASH_SEED);
+  TestType other(16, HASH_SEED + 1);
+  REQUIRE(filter1.hash_seed() == HASH_SEED);
+  for (size_t i = 0; i < INSERT_NUM; i++) {
+    REQUIRE(filter1.insert(nums[i]) == dff::Ok);
+    REQUIRE(filter2.insert(nums[i]) == dff::Ok);
+    REQUIRE(other.insert(nums[i]) == dff::Ok);
+  }
+
+  std::stringstream ss1;
+  std::stringstream ss2;
+  REQUIRE(filter1.save(ss1) == dff::Ok);
+  REQUIRE(filter2.save(ss2) == dff::Ok);
+  REQUIRE(ss1.str() == ss2.str());
+
+  size_t different = 0;
+  for (size_t i = INSERT_NUM; i < GENERATE_NUM; i++)
+    if (filter1.query(nums[i]) != other.query(nums[i]))
+      different++;
+  REQUIRE(different > 0);
+
+  // The seed is kept by saving and loading
+  TestType loaded(16);
+  REQUIRE(loaded.load(ss1) == dff::Ok);
+  REQUIRE(loaded.hash_seed() == HASH_SEED);
+
+  delete[] nums;
+}
+
+TEMPLATE_TEST_CASE("DFF should merge filters sharing a hash seed", "[dff]",
+                   (dff::DFF<uint64_t, false>), (dff::DFF<uint64_t, true>)) {
+  constexpr size_t GENERATE_NUM = INSERT_NUM * 2;
+  constexpr size_t SPLIT_NUM = INSERT_NUM / 4;
+  auto *nums = new uint64_t[GENERATE_NUM];
+  random_gen(GENERATE_NUM, nums);
+
+  // The larger filter is split further
+  constexpr uint64_t HASH_SEED = 12821;
+  TestType small(16, HASH_SEED);
+  TestType large(16, HASH_SEED);
+  for (size_t i = 0; i < SPLIT_NUM; i++)
+    REQUIRE(small.insert(nums[i]) == dff::Ok);
+  for (size_t i = SPLIT_NUM; i < INSERT_NUM; i++)
+    REQUIRE(large.insert(nums[i]) == dff::Ok);
+  REQUIRE(small.num_seg < large.num_seg);
+
+  const auto check_merged = [&](TestType &merged) {
+    for (size_t i = 0; i < INSERT_NUM; i++)
+      REQUIRE(merged.query(nums[i]) == dff::Ok);
+    size_t false_positive = 0;
+    for (size_t i = INSERT_NUM; i < GENERATE_NUM; i++)
+      if (merged.query(nums[i]) == dff::Ok)
+        false_positive++;
+    REQUIRE(static_cast<double>(false_positive) / static_cast<double>(INSERT_NUM) < 0.01);
+
+    // Merged items can be removed like inserted ones
+    for (size_t i = 0; i < INSERT_NUM; i++)
+      REQUIRE(merged.remove(nums[i]) == dff::Ok);
+    false_positive = 0;
+    for (size_t i = 0; i < INSERT_NUM; i++)
+      if (merged.query(nums[i]) == dff::Ok)
+        false_positive++;
+    REQUIRE(false_positive == 0);
+  };
+
+  SECTION("A larger filter should be merged into a smaller one") {
+    REQUIRE(small.merge_from(large) == dff::Ok);
+    REQUIRE(small.num_seg >= large.num_seg);
+    for (size_t i = SPLIT_NUM; i < INSERT_NUM; i++)
+      REQUIRE(large.query(nums[i]) == dff::Ok);
+    check_merged(small);
+  }
+
+  SECTION("A smaller filter should be merged into a larger one") {
+    const size_t num_seg = large.num_seg;
+    REQUIRE(large.merge_from(small) == dff::Ok);
+    REQUIRE(large.num_seg >= num_seg);
+    check_merged(large);
+  }
+
+  SECTION("Items lost by a saturated filter should be counted once per segment") {
+    TestType budgeted(16, HASH_SEED);
+    budgeted.set_memory_budget(budgeted.memory_usage() * 3 / 2);
+    for (size_t i = 0; i < INSERT_NUM; i++)
+      REQUIRE(budgeted.insert(nums[i]) == dff::Ok);
+
+    TestType merged(16, HASH_SEED);
+    REQUIRE(merged.merge_from(budgeted) == dff::Ok);
+    for (size_t i = 0; i < INSERT_NUM; i++)
+      REQUIRE(merged.query(nums[i]) == dff::Ok);
+    // Each segment counts the items lost by the segment its slots were merged from, which it may
+    // have been expanded from since
+    uint64_t num_lost = 0;
+    uint64_t expected_num_lost = 0;
+    for (const auto *seg = merged.head; seg != nullptr; seg = seg->next) {
+      num_lost += seg->num_lost;
+      expected_num_lost += budgeted.lookup_table[seg->first_lut_slot]->num_lost;
+    }
+    REQUIRE(expected_num_lost > 0);
+    REQUIRE(num_lost == expected_num_lost);
+  }
+
+  SECTION("Filters with another hash seed should not be merged") {
+    TestType other(16, HASH_SEED + 1);
+    REQUIRE(other.merge_from(small) == dff::NotSupported);
+    REQUIRE(small.merge_from(small) == dff::NotSupported);
+  }
+
+  delete[] nums;
+}
+
+TEMPLATE_TEST_CASE("DFF should be saved and loaded correctly", "[dff]",
+                   (dff::DFF<uint64_t, false>), (dff::DFF<uint64_t, true>)) {
+  constexpr size_t GENERATE_NUM = INSERT_NUM * 2;
+  auto *nums = new uint64_t[GENERATE_NUM];
+  random_gen(GENERATE_NUM, nums);
+
+  TestType filter(16);
+  for (size_t i = 0; i < INSERT_NUM; i++)
+    REQUIRE(filter.insert(nums[i]) == dff::Ok);
+
+  SECTION("A loaded filter should answer queries the same way") {
+    const auto path = (std::filesystem::temp_directory_path() / "test_dff.bin").string();
+    REQUIRE(filter.save(path) == dff::Ok);
+
+    TestType loaded(8);
+    REQUIRE(loaded.load(path) == dff::Ok);
+    std::filesystem::remove(path);
+    REQUIRE(loaded.num_seg == filter.num_seg);
+    REQUIRE(loaded.memory_usage() == filter.memory_usage());
+    for (size_t i = 0; i < GENERATE_NUM; i++)
+      REQUIRE(loaded.query(nums[i]) == filter.query(nums[i]));
+
+    // The loaded filter should keep working
+    for (size_t i = INSERT_NUM; i < GENERATE_NUM; i++)
+      REQUIRE(loaded.insert(nums[i]) == dff::Ok);
+    for (size_t i = 0; i < GENERATE_NUM; i++)
+      REQUIRE(loaded.remove(nums[i]) == dff::Ok);
+  }
+
+#if defined(__unix__) || defined(__APPLE__)
+  SECTION("A memory mapped filter should answer queries the same way") {
+    const auto path = (std::filesystem::temp_directory_path() / "test_dff_mmap.bin").string();
+    REQUIRE(filter.save(path) == dff::Ok);
+
+    TestType mapped(16);
+    REQUIRE(mapped.open_mmap(path) == dff::Ok);
+    REQUIRE(mapped.num_seg == filter.num_seg);
+    for (size_t i = 0; i < GENERATE_NUM; i++)
+      REQUIRE(mapped.query(nums[i]) == filter.query(nums[i]));
+
+    // Changes are private to the filter, the file is not modified
+    for (size_t i = INSERT_NUM; i < GENERATE_NUM; i++)
+      REQUIRE(mapped.insert(nums[i]) == dff::Ok);
+    for (size_t i = 0; i < INSERT_NUM; i++)
+      REQUIRE(mapped.remove(nums[i]) == dff::Ok);
+    TestType loaded(16);
+    REQUIRE(loaded.load(path) == dff::Ok);
+    for (size_t i = 0; i < GENERATE_NUM; i++)
+      REQUIRE(loaded.query(nums[i]) == filter.query(nums[i]));
+
+    // A clone does not depend on the mapping
+    TestType clone = mapped.clone();
+    mapped = TestType(16);
+    for (size_t i = INSERT_NUM; i < GENERATE_NUM; i++)
+      REQUIRE(clone.query(nums[i]) == dff::Ok);
+
+    std::filesystem::remove(path);
+  }
+#endif
+
+  SECTION("Imported tags should rebuild the filter") {
+    std::stringstream saved;
+    REQUIRE(filter.save(saved) == dff::Ok);
+    std::stringstream exported;
+    REQUIRE(filter.export_tags(exported) == dff::Ok);
+    const std::string data = exported.str();
+    REQUIRE(data.size() < saved.str().size());
+
+    size_t num_tags = 0;
+    filter.for_each_tag([&](const typename TestType::TagRecord &record) {
+      REQUIRE(filter.lookup_table[record.first_slot]->lut_slots_count == record.slot_count);
+      num_tags++;
+    });
+    REQUIRE(num_tags >= INSERT_NUM * 99 / 100);
+
+    TestType imported(16);
+    REQUIRE(imported.import_tags(exported) == dff::Ok);
+    REQUIRE(imported.num_seg == filter.num_seg);
+    REQUIRE(imported.hash_seed() == filter.hash_seed());
+    for (size_t i = 0; i < GENERATE_NUM; i++)
+      REQUIRE(imported.query(nums[i]) == filter.query(nums[i]));
+
+    // The tags of each bucket are kept in order
+    std::stringstream reexported;
+    REQUIRE(imported.export_tags(reexported) == dff::Ok);
+    REQUIRE(reexported.str() == data);
+
+    // The imported filter should keep working
+    for (size_t i = INSERT_NUM; i < GENERATE_NUM; i++)
+      REQUIRE(imported.insert(nums[i]) == dff::Ok);
+    for (size_t i = 0; i < GENERATE_NUM; i++)
+      REQUIRE(imported.remove(nums[i]) == dff::Ok);
+
+    // Truncated
+    std::stringstream truncated(data.substr(0, data.size() - 1));
+    REQUIRE(imported.import_tags(truncated) == dff::IOError);
+    std::stringstream saved_copy(saved.str());
+    REQUIRE(imported.import_tags(saved_copy) == dff::IOError);
+    REQUIRE(imported.num_seg > dff::INITIAL_SEG_COUNT);
+  }
+
+  SECTION("Malformed data should be rejected without touching the filter") {
+    std::stringstream ss;
+    REQUIRE(filter.save(ss) == dff::Ok);
+    const std::string data = ss.str();
+
+    TestType loaded(16);
+    REQUIRE(loaded.insert(nums[0]) == dff::Ok);
+
+    // Truncated
+    std::stringstream truncated(data.substr(0, data.size() - 1));
+    REQUIRE(loaded.load(truncated) == dff::IOError);
+    // Bad magic
+    std::string bad_magic = data;
+    bad_magic[0] ^= 1;
+    std::stringstream bad_magic_ss(bad_magic);
+    REQUIRE(loaded.load(bad_magic_ss) == dff::IOError);
+    // Another fingerprint growth mode
+    std::stringstream another_mode;
+    dff::DFF<uint64_t, !std::is_same_v<TestType, dff::DFF<uint64_t, true>>> another(16);
+    REQUIRE(another.save(another_mode) == dff::Ok);
+    REQUIRE(loaded.load(another_mode) == dff::NotSupported);
+
+    REQUIRE(loaded.num_seg == dff::INITIAL_SEG_COUNT);
+    REQUIRE(loaded.query(nums[0]) == dff::Ok);
+  }
+
+  delete[] nums;
+}
+
+TEMPLATE_TEST_CASE("DFF should checkpoint only dirty segments", "[dff]",
+                   (dff::DFF<uint64_t, false>), (dff::DFF<uint64_t, true>)) {
+  constexpr size_t GENERATE_NUM = INSERT_NUM * 2;
+  auto *nums = new uint64_t[GENERATE_NUM];
+  random_gen(GENERATE_NUM, nums);
+
+  const auto dir = std::filesystem::temp_directory_path() / "test_dff_checkpoint";
+  std::filesystem::remove_all(dir);
+  const auto count_segment_files = [&dir](const std::string &suffix) {
+    size_t count = 0;
+    for (const auto &entry : std::filesystem::directory_iterator(dir))
+      if (entry.path().filename().string().ends_with(suffix))
+        count++;
+    return count;
+  };
+
+  TestType filter(16);
+  for (size_t i = 0; i < INSERT_NUM; i++)
+    REQUIRE(filter.insert(nums[i]) == dff::Ok);
+
+  // The first checkpoint writes all segments
+  REQUIRE(filter.checkpoint(dir.string()) == dff::Ok);
+  REQUIRE(count_segment_files("_1.bin") == filter.num_seg);
+
+  // Only the segment written to is written again
+  REQUIRE(filter.remove(nums[0]) == dff::Ok);
+  REQUIRE(filter.checkpoint(dir.string()) == dff::Ok);
+  REQUIRE(count_segment_files("_2.bin") == 1);
+  REQUIRE(count_segment_files(".bin") == filter.num_seg + 1 /* manifest */);
+
+  // Expanded segments are written too
+  for (size_t i = INSERT_NUM; i < GENERATE_NUM; i++)
+    REQUIRE(filter.insert(nums[i]) == dff::Ok);
+  REQUIRE(filter.checkpoint(dir.string()) == dff::Ok);
+  REQUIRE(count_segment_files(".bin") == filter.num_seg + 1);
+
+  TestType restored(16);
+  REQUIRE(restored.restore(dir.string()) == dff::Ok);
+  REQUIRE(restored.num_seg == filter.num_seg);
+  REQUIRE(restored.query(nums[0]) == filter.query(nums[0]));
+  for (size_t i = 1; i < GENERATE_NUM; i++)
+    REQUIRE(restored.query(nums[i]) == dff::Ok);
+
+  // Checkpoints of the restored filter are incremental
+  REQUIRE(restored.remove(nums[1]) == dff::Ok);
+  REQUIRE(restored.checkpoint(dir.string()) == dff::Ok);
+  REQUIRE(count_segment_files("_4.bin") == 1);
+
+  // A copy starts its own checkpoints from scratch
+  TestType copy = restored.clone();
+  std::filesystem::remove_all(dir);
+  REQUIRE(copy.checkpoint(dir.string()) == dff::Ok);
+  REQUIRE(count_segment_files("_1.bin") == copy.num_seg);
+
+  std::filesystem::remove_all(dir);
+  delete[] nums;
+}
+
+TEMPLATE_TEST_CASE("DFF snapshots should not see later changes", "[dff]",
+                   (dff::DFF<uint64_t, false>), (dff::DFF<uint64_t, true>)) {
+  constexpr size_t GENERATE_NUM = INSERT_NUM * 2;
+  auto *nums = new uint64_t[GENERATE_NUM];
+  random_gen(GENERATE_NUM, nums);
+
+  auto *filter = new TestType(16);
+  for (size_t i = 0; i < INSERT_NUM; i++)
+    REQUIRE(filter->insert(nums[i]) == dff::Ok);
+  TestType before = filter->clone();
+  auto snapshot = filter->snapshot();
+  const size_t initial_exclusive_memory_usage = snapshot.exclusive_memory_usage();
+
+  // Expand, shrink and compact the filter while the snapshot is held
+  for (size_t i = INSERT_NUM; i < GENERATE_NUM; i++)
+    REQUIRE(filter->insert(nums[i]) == dff::Ok);
+  REQUIRE(snapshot.exclusive_memory_usage() > initial_exclusive_memory_usage);
+  for (size_t i = 0; i < GENERATE_NUM - 1000; i++)
+    REQUIRE(filter->remove(nums[i]) == dff::Ok);
+  REQUIRE(filter->compact() == dff::Ok);
+  for (size_t i = GENERATE_NUM - 1000; i < GENERATE_NUM; i++)
+    REQUIRE(filter->query(nums[i]) == dff::Ok);
+
+  for (size_t i = 0; i < GENERATE_NUM; i++)
+    REQUIRE(snapshot.query(nums[i]) == before.query(nums[i]));
+
+  // The snapshot outlives the filter
+  delete filter;
+  std::stringstream ss;
+  REQUIRE(snapshot.save(ss) == dff::Ok);
+  TestType loaded(16);
+  REQUIRE(loaded.load(ss) == dff::Ok);
+  REQUIRE(loaded.num_seg == before.num_seg);
+  for (size_t i = 0; i < GENERATE_NUM; i++)
+    REQUIRE(loaded.query(nums[i]) == before.query(nums[i]));
+
+  delete[] nums;
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+TEMPLATE_TEST_CASE("DFF should recover operations from its log", "[dff]",
+                   (dff::DFF<uint64_t, false>), (dff::DFF<uint64_t, true>)) {
+  constexpr size_t GENERATE_NUM = INSERT_NUM * 2;
+  auto *nums = new uint64_t[GENERATE_NUM];
+  random_gen(GENERATE_NUM, nums);
+
+  const auto path = (std::filesystem::temp_directory_path() / "test_dff_log.bin").string();
+  std::filesystem::remove(path);
+
+  TestType filter(16);
+  for (size_t i = 0; i < INSERT_NUM; i++)
+    REQUIRE(filter.insert(nums[i]) == dff::Ok);
+  std::stringstream ss;
+  REQUIRE(filter.save(ss) == dff::Ok);
+  const std::string snapshot = ss.str();
+  const auto load_snapshot = [&snapshot](TestType &target) {
+    std::istringstream is(snapshot);
+    return target.load(is);
+  };
+
+  REQUIRE(filter.open_log(path, 64) == dff::Ok);
+  for (size_t i = INSERT_NUM; i < GENERATE_NUM; i++)
+    REQUIRE(filter.insert(nums[i]) == dff::Ok);
+  for (size_t i = 0; i < INSERT_NUM / 2; i++)
+    REQUIRE(filter.remove(nums[i]) == dff::Ok);
+  REQUIRE(filter.close_log() == dff::Ok);
+
+  TestType recovered(16);
+  // The log is bound to the hash seed of the filter
+  REQUIRE(recovered.replay_log(path) == dff::NotSupported);
+  REQUIRE(load_snapshot(recovered) == dff::Ok);
+  REQUIRE(recovered.replay_log(path) == dff::Ok);
+  REQUIRE(recovered.num_seg == filter.num_seg);
+  for (size_t i = 0; i < GENERATE_NUM; i++)
+    REQUIRE(recovered.query(nums[i]) == filter.query(nums[i]));
+
+  SECTION("A torn entry at the end of the log should be dropped") {
+    {
+      std::ofstream os(path, std::ios::binary | std::ios::app);
+      os.write("torn", 4);
+    }
+    TestType reloaded(16);
+    REQUIRE(load_snapshot(reloaded) == dff::Ok);
+    REQUIRE(reloaded.replay_log(path) == dff::Ok);
+
+    // New entries are appended after the last complete entry
+    REQUIRE(filter.open_log(path, 1) == dff::Ok);
+    REQUIRE(filter.remove(nums[INSERT_NUM / 2]) == dff::Ok);
+    REQUIRE(filter.close_log() == dff::Ok);
+    REQUIRE(load_snapshot(reloaded) == dff::Ok);
+    REQUIRE(reloaded.replay_log(path) == dff::Ok);
+    for (size_t i = 0; i < GENERATE_NUM; i++)
+      REQUIRE(reloaded.query(nums[i]) == filter.query(nums[i]));
+  }
+
+  SECTION("A malformed log should be rejected without touching the filter") {
+    {
+      std::fstream fs(path, std::ios::binary | std::ios::in | std::ios::out);
+      fs.seekp(-1, std::ios::end);
+      fs.put(static_cast<char>(0x7F));
+    }
+    TestType reloaded(16);
+    TestType untouched(16);
+    REQUIRE(load_snapshot(reloaded) == dff::Ok);
+    REQUIRE(load_snapshot(untouched) == dff::Ok);
+    REQUIRE(reloaded.replay_log(path) == dff::IOError);
+    for (size_t i = 0; i < GENERATE_NUM; i++)
+      REQUIRE(reloaded.query(nums[i]) == untouched.query(nums[i]));
+  }
+
+  std::filesystem::remove(path);
+  delete[] nums;
+}
+
+TEST_CASE("DFF should replay the operations on a segment in log order", "[dff]") {
+  constexpr size_t CANDIDATE_NUM = 1'000;
+  constexpr size_t PROBE_NUM = 100'000;
+  constexpr size_t PAIR_NUM = 8;
+  auto *nums = new uint64_t[CANDIDATE_NUM + PROBE_NUM];
+  random_gen(CANDIDATE_NUM + PROBE_NUM, nums);
+
+  const auto path = (std::filesystem::temp_directory_path() / "test_dff_log_order.bin").string();
+
+  // Pairs of items with the same tag in the same buckets (so in the same segment), found as false
+  // positives of 8-bit tags
+  std::vector<std::pair<uint64_t, uint64_t>> pairs;
+  dff::DFF<uint64_t, false> candidates(8, 42);
+  for (size_t i = 0; i < CANDIDATE_NUM; i++)
+    REQUIRE(candidates.insert(nums[i]) == dff::Ok);
+  for (size_t j = CANDIDATE_NUM; j < CANDIDATE_NUM + PROBE_NUM && pairs.size() < PAIR_NUM; j++) {
+    if (candidates.query(nums[j]) != dff::Ok)
+      continue;
+    for (size_t i = 0; i < CANDIDATE_NUM; i++) {
+      dff::DFF<uint64_t, false> single(8, 42);
+      REQUIRE(single.insert(nums[i]) == dff::Ok);
+      if (single.query(nums[j]) == dff::Ok) {
+        pairs.emplace_back(nums[i], nums[j]);
+        break;
+      }
+    }
+  }
+  REQUIRE(pairs.size() == PAIR_NUM);
+
+  // Removing an absent item before inserting a colliding one must not remove the inserted one on
+  // replay, with batches partitioned by segment or, with automatic shrinking, applied as logged
+  for (const bool shrink : {false, true}) {
+    for (const auto &[first, second] : pairs) {
+      for (const auto &[absent, inserted] : {std::pair{first, second}, std::pair{second, first}}) {
+        std::filesystem::remove(path);
+        dff::DFF<uint64_t, false> filter(8, 42);
+        REQUIRE(filter.set_shrink_autonomously(shrink) == dff::Ok);
+        std::stringstream ss;
+        REQUIRE(filter.save(ss) == dff::Ok);
+        REQUIRE(filter.open_log(path, 1) == dff::Ok);
+        REQUIRE(filter.remove(absent) == dff::NotFound);
+        REQUIRE(filter.insert(inserted) == dff::Ok);
+        REQUIRE(filter.close_log() == dff::Ok);
+
+        dff::DFF<uint64_t, false> recovered(8, 42);
+        REQUIRE(recovered.set_shrink_autonomously(shrink) == dff::Ok);
+        REQUIRE(recovered.load(ss) == dff::Ok);
+        REQUIRE(recovered.replay_log(path) == dff::Ok);
+        REQUIRE(recovered.query(inserted) == dff::Ok);
+      }
+    }
+  }
+
+  std::filesystem::remove(path);
+  delete[] nums;
+}
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+TEMPLATE_TEST_CASE("DFF should keep its segments in a growing mapped file", "[dff]",
+                   (dff::DFF<uint64_t, false>), (dff::DFF<uint64_t, true>)) {
+  constexpr size_t GENERATE_NUM = INSERT_NUM * 2;
+  auto *nums = new uint64_t[GENERATE_NUM];
+  random_gen(GENERATE_NUM, nums);
+
+  const auto path = (std::filesystem::temp_directory_path() / "test_dff_arena.bin").string();
+  // Small chunks, so that the file grows many times
+  MappedFileArena arena(1UZ << 18);
+  REQUIRE(arena.open(path));
+  {
+    TestType filter(16, &arena);
+    const size_t initial_file_size = arena.file_size();
+    REQUIRE(initial_file_size > 0);
+    for (size_t i = 0; i < INSERT_NUM; i++)
+      REQUIRE(filter.insert(nums[i]) == dff::Ok);
+    REQUIRE(arena.file_size() > initial_file_size);
+    REQUIRE(std::filesystem::file_size(path) == arena.file_size());
+
+    // Evicted segments are read back from the file
+    REQUIRE(arena.evict());
+    arena.advise_cold();
+    for (size_t i = 0; i < INSERT_NUM; i++)
+      REQUIRE(filter.query(nums[i]) == dff::Ok);
+
+    TestType clone = filter.clone();
+    for (size_t i = 0; i < INSERT_NUM; i++)
+      REQUIRE(filter.remove(nums[i]) == dff::Ok);
+    for (size_t i = 0; i < INSERT_NUM; i++)
+      REQUIRE(filter.query(nums[i]) == dff::NotFound);
+    for (size_t i = 0; i < INSERT_NUM; i++)
+      REQUIRE(clone.query(nums[i]) == dff::Ok);
+
+    // The arena never gives memory back, so its segments are never merged, unlike the clone's
+    REQUIRE(filter.compact() == dff::NotSupported);
+    REQUIRE(filter.set_shrink_autonomously(true) == dff::NotSupported);
+    REQUIRE(filter.set_shrink_autonomously(false) == dff::Ok);
+    REQUIRE(clone.compact() == dff::Ok);
+  }
+
+  arena.close();
+  std::filesystem::remove(path);
+  delete[] nums;
+}
+#endif
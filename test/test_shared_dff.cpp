@@ -0,0 +1,122 @@
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <thread>
+
+#include <catch2/catch_template_test_macros.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/SharedDFF.hpp"
+#include "../src/predefine.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+
+constexpr size_t INSERT_NUM = 300'000;
+
+// generate the integers
+inline void random_gen(size_t n, uint64_t *store) {
+  std::mt19937 rd(12821);
+  const auto rand_range = static_cast<uint64_t>(std::pow(2, 64) / static_cast<double>(n));
+  for (size_t i = 0; i < n; i++) {
+    uint64_t rand = rand_range * i + rd() % rand_range;
+    store[i] = rand;
+  }
+}
+
+TEMPLATE_TEST_CASE("SharedDFF readers should see the writer's filter", "[shared_dff]",
+                   (dff::SharedDFF<uint64_t, false>), (dff::SharedDFF<uint64_t, true>)) {
+  constexpr size_t GENERATE_NUM = INSERT_NUM * 2;
+  constexpr size_t SHARED_SIZE = 64UZ << 20;
+  auto *nums = new uint64_t[GENERATE_NUM];
+  random_gen(GENERATE_NUM, nums);
+
+  const std::string name = "/dff_test_" + std::to_string(::getpid());
+  TestType::unlink(name);
+  TestType writer;
+  REQUIRE(writer.create(name, 16, SHARED_SIZE) == dff::Ok);
+  TestType reader;
+  REQUIRE(reader.open(name) == dff::Ok);
+
+  SECTION("Readers should not modify the filter") {
+    REQUIRE(reader.insert(nums[0]) == dff::NotSupported);
+    REQUIRE(reader.remove(nums[0]) == dff::NotSupported);
+  }
+
+  SECTION("Readers should find the inserted items, and lose the removed ones") {
+    for (size_t i = 0; i < INSERT_NUM; i++)
+      REQUIRE(writer.insert(nums[i]) == dff::Ok);
+    REQUIRE(reader.num_seg() > dff::INITIAL_SEG_COUNT);
+    for (size_t i = 0; i < INSERT_NUM; i++)
+      REQUIRE(reader.query(nums[i]) == dff::Ok);
+
+    for (size_t i = 0; i < INSERT_NUM / 2; i++)
+      REQUIRE(writer.remove(nums[i]) == dff::Ok);
+    for (size_t i = 0; i < GENERATE_NUM; i++)
+      REQUIRE(reader.query(nums[i]) == writer.query(nums[i]));
+  }
+
+  SECTION("Readers should not see false negatives while the writer inserts") {
+    for (size_t i = 0; i < INSERT_NUM / 2; i++)
+      REQUIRE(writer.insert(nums[i]) == dff::Ok);
+
+    std::atomic<bool> done = false;
+    std::atomic<size_t> false_negative = 0;
+    std::thread reader_thread([&] {
+      while (!done.load())
+        for (size_t i = 0; i < INSERT_NUM / 2; i += 97)
+          if (reader.query(nums[i]) != dff::Ok)
+            false_negative++;
+    });
+    for (size_t i = INSERT_NUM / 2; i < INSERT_NUM; i++)
+      REQUIRE(writer.insert(nums[i]) == dff::Ok);
+    done = true;
+    reader_thread.join();
+
+    REQUIRE(false_negative == 0);
+    for (size_t i = 0; i < INSERT_NUM; i++)
+      REQUIRE(reader.query(nums[i]) == dff::Ok);
+  }
+
+  SECTION("Invalid shared memory objects should be rejected") {
+    TestType other;
+    REQUIRE(other.create(name, 16, SHARED_SIZE) == dff::IOError);
+    REQUIRE(other.create(name + "_small", 16, TestType::min_size(16) - 1) ==
+            dff::NotEnoughSpace);
+    REQUIRE(other.open(name + "_missing") == dff::IOError);
+    REQUIRE(other.query(nums[0]) == dff::NotSupported);
+  }
+
+  reader.close();
+  writer.close();
+  REQUIRE(TestType::unlink(name) == dff::Ok);
+  delete[] nums;
+}
+
+TEST_CASE("SharedDFF should report a full shared memory object", "[shared_dff]") {
+  constexpr size_t GENERATE_NUM = INSERT_NUM;
+  auto *nums = new uint64_t[GENERATE_NUM];
+  random_gen(GENERATE_NUM, nums);
+
+  const std::string name = "/dff_test_full_" + std::to_string(::getpid());
+  dff::SharedDFF<uint64_t>::unlink(name);
+  dff::SharedDFF<uint64_t> writer;
+  REQUIRE(writer.create(name, 16, dff::SharedDFF<uint64_t>::min_size(16)) == dff::Ok);
+
+  // Items are kept until the initial segments cannot take more
+  size_t inserted = 0;
+  while (inserted < GENERATE_NUM && writer.insert(nums[inserted]) == dff::Ok)
+    inserted++;
+  REQUIRE(inserted < GENERATE_NUM);
+  REQUIRE(writer.num_seg() == dff::INITIAL_SEG_COUNT);
+  for (size_t i = 0; i < inserted; i++)
+    REQUIRE(writer.query(nums[i]) == dff::Ok);
+
+  writer.close();
+  REQUIRE(dff::SharedDFF<uint64_t>::unlink(name) == dff::Ok);
+  delete[] nums;
+}
+
+#endif